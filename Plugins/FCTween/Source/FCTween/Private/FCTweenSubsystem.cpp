@@ -1,8 +1,50 @@
 ﻿#include "FCTweenSubsystem.h"
 
 #include "FCTween.h"
+#include "Engine/GameInstance.h"
 #include "Kismet/GameplayStatics.h"
 
+namespace FCTweenSubsystem
+{
+	// frame a tween was started from the console, to count the frames until its first update
+	static uint64 MeasureStartFrame = 0;
+
+	static void MeasureFrameDelay()
+	{
+		MeasureStartFrame = GFrameCounter;
+		FCTween::Play(
+			0.0f, 1.0f,
+			[](float)
+			{
+				if (MeasureStartFrame != 0)
+				{
+					UE_LOG(LogFCTween, Display, TEXT("Tween frame delay: first update %llu frame(s) after Play"),
+						GFrameCounter - MeasureStartFrame);
+					MeasureStartFrame = 0;
+				}
+			},
+			0.1f);
+	}
+
+	static FAutoConsoleCommand MeasureFrameDelayCommand(TEXT("FCTween.MeasureFrameDelay"),
+		TEXT("Starts a tween and logs how many frames pass before its first update, 0 when it moves in the frame it was started."),
+		FConsoleCommandDelegate::CreateStatic(&MeasureFrameDelay));
+}
+
+void FFCTweenTickFunction::ExecuteTick(
+	float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target != nullptr)
+	{
+		Target->UpdateTweens();
+	}
+}
+
+FString FFCTweenTickFunction::DiagnosticMessage()
+{
+	return TEXT("FCTween[UpdateTweens]");
+}
+
 void UFCTweenSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
 	Super::Initialize(Collection);
@@ -14,6 +56,19 @@ void UFCTweenSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 		LastRealTimeSeconds = GetWorld()->RealTimeSeconds;
 	}
 #endif
+
+	TweenTickFunction.Target = this;
+	TweenTickFunction.bCanEverTick = true;
+	TweenTickFunction.bTickEvenWhenPaused = true;
+	TweenTickFunction.TickGroup = TickGroup;
+
+	// the tick function lives in the current world's persistent level, follow the game instance from world to world
+	WorldInitializedActorsHandle = FWorldDelegates::OnWorldInitializedActors.AddUObject(this, &UFCTweenSubsystem::OnWorldInitializedActors);
+	WorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddUObject(this, &UFCTweenSubsystem::OnWorldCleanup);
+	if (GetWorld() != nullptr && GetWorld()->AreActorsInitialized())
+	{
+		RegisterTweenTick(GetWorld());
+	}
 	
 #if WITH_EDITOR
 	FCTween::ClearActiveTweens();
@@ -22,6 +77,10 @@ void UFCTweenSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 
 void UFCTweenSubsystem::Deinitialize()
 {
+	FWorldDelegates::OnWorldInitializedActors.Remove(WorldInitializedActorsHandle);
+	FWorldDelegates::OnWorldCleanup.Remove(WorldCleanupHandle);
+	UnregisterTweenTick();
+
 	Super::Deinitialize();
 #if WITH_EDITOR
 	FCTween::CheckTweenCapacity();
@@ -29,7 +88,54 @@ void UFCTweenSubsystem::Deinitialize()
 #endif
 }
 
-void UFCTweenSubsystem::Tick(float DeltaTime)
+void UFCTweenSubsystem::RegisterTweenTick(UWorld* World)
+{
+	UnregisterTweenTick();
+	if (World != nullptr && World->PersistentLevel != nullptr)
+	{
+		TweenTickFunction.RegisterTickFunction(World->PersistentLevel);
+	}
+}
+
+void UFCTweenSubsystem::UnregisterTweenTick()
+{
+	if (TweenTickFunction.IsTickFunctionRegistered())
+	{
+		TweenTickFunction.UnRegisterTickFunction();
+	}
+}
+
+void UFCTweenSubsystem::OnWorldInitializedActors(const UWorld::FActorsInitializedParams& Params)
+{
+	if (Params.World != nullptr && Params.World->GetGameInstance() == GetGameInstance())
+	{
+		RegisterTweenTick(Params.World);
+	}
+}
+
+void UFCTweenSubsystem::OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
+{
+	if (World != nullptr && World->GetGameInstance() == GetGameInstance())
+	{
+		UnregisterTweenTick();
+	}
+}
+
+void UFCTweenSubsystem::SetTickGroup(TEnumAsByte<ETickingGroup> InTickGroup)
+{
+	TickGroup = InTickGroup;
+
+	// the tick group only takes effect on registration
+	const bool bWasRegistered = TweenTickFunction.IsTickFunctionRegistered();
+	UnregisterTweenTick();
+	TweenTickFunction.TickGroup = TickGroup;
+	if (bWasRegistered)
+	{
+		RegisterTweenTick(GetWorld());
+	}
+}
+
+void UFCTweenSubsystem::UpdateTweens()
 {
 	if (LastTickedFrame < GFrameCounter)
 	{
@@ -48,9 +154,20 @@ void UFCTweenSubsystem::Tick(float DeltaTime)
 	}
 }
 
+void UFCTweenSubsystem::Tick(float DeltaTime)
+{
+	// fallback while no world tick function is registered
+	UpdateTweens();
+}
+
 ETickableTickType UFCTweenSubsystem::GetTickableTickType() const
 {
-	return ETickableTickType::Always;
+	return ETickableTickType::Conditional;
+}
+
+bool UFCTweenSubsystem::IsTickable() const
+{
+	return !TweenTickFunction.IsTickFunctionRegistered();
 }
 
 TStatId UFCTweenSubsystem::GetStatId() const
@@ -0,0 +1,99 @@
+// MIT License - Copyright (c) 2022 Jared Cook
+#include "Misc/AutomationTest.h"
+
+#include "FCTween.h"
+#include "FCTweenSubsystem.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FCTweenSubsystemTest
+{
+	// stands in for input or gameplay starting a tween early in the frame
+	struct FStartTweenTickFunction : public FTickFunction
+	{
+		TFunction<void()> OnTick;
+
+		virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread,
+			const FGraphEventRef& MyCompletionGraphEvent) override
+		{
+			if (OnTick)
+			{
+				OnTick();
+				OnTick = nullptr;
+			}
+		}
+
+		virtual FString DiagnosticMessage() override
+		{
+			return TEXT("FCTweenSubsystemTest[StartTween]");
+		}
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFCTweenSameFrameTest, "FCTween.Subsystem.SameFrameUpdate",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFCTweenSameFrameTest::RunTest(const FString& Parameters)
+{
+	// a standalone game instance creates its own world and the tween subsystem with it
+	UGameInstance* GameInstance = NewObject<UGameInstance>(GEngine);
+	GameInstance->InitializeStandalone();
+	UWorld* World = GameInstance->GetWorld();
+	UFCTweenSubsystem* Subsystem = GameInstance->GetSubsystem<UFCTweenSubsystem>();
+
+	if (TestNotNull(TEXT("World"), World) && TestNotNull(TEXT("Tween subsystem"), Subsystem))
+	{
+		// registers the tween tick function in the persistent level
+		World->InitializeActorsForPlay(FURL());
+		TestFalse(TEXT("Tweens updated by the tick function rather than the tickable fallback"), Subsystem->IsTickable());
+
+		uint64 PlayFrame = 0;
+		uint64 FirstUpdateFrame = 0;
+		float Value = 0.0f;
+
+		FCTweenSubsystemTest::FStartTweenTickFunction StartTick;
+		StartTick.bCanEverTick = true;
+		StartTick.TickGroup = TG_PrePhysics;
+		StartTick.OnTick = [&PlayFrame, &FirstUpdateFrame, &Value]()
+		{
+			PlayFrame = GFrameCounter;
+			FCTween::Play(
+				0.0f, 1.0f,
+				[&FirstUpdateFrame, &Value](float InValue)
+				{
+					if (FirstUpdateFrame == 0)
+					{
+						FirstUpdateFrame = GFrameCounter;
+					}
+					Value = InValue;
+				},
+				1.0f, EFCEase::Linear);
+		};
+		StartTick.RegisterTickFunction(World->PersistentLevel);
+
+		// one frame as the engine loop runs it: the frame counter moves, then the world ticks every group
+		GFrameCounter++;
+		World->Tick(LEVELTICK_All, 1.0f / 60.0f);
+
+		TestTrue(TEXT("Tween started during the frame"), PlayFrame != 0);
+		TestEqual(TEXT("Frames between Play and the first update"), (int64)(FirstUpdateFrame - PlayFrame), (int64)0);
+		TestTrue(TEXT("Target moved in the frame the tween started"), Value > 0.0f);
+
+		StartTick.UnRegisterTickFunction();
+	}
+
+	FCTween::ClearActiveTweens();
+	GameInstance->Shutdown();
+	if (World != nullptr)
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+	return true;
+}
+
+#endif
@@ -1,8 +1,37 @@
 ﻿// MIT License - Copyright (c) 2022 Jared Cook
 #pragma once
+#include "Engine/EngineBaseTypes.h"
+#include "Engine/World.h"
 #include "FCTweenSubsystem.generated.h"
 
-UCLASS()
+class UFCTweenSubsystem;
+
+/**
+ * Runs the tween update inside the world's tick, in a chosen tick group, so tweens started by input or gameplay earlier in
+ * the frame move their targets before the frame's render state is sent.
+ */
+USTRUCT()
+struct FFCTweenTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UFCTweenSubsystem* Target = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread,
+		const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template <>
+struct TStructOpsTypeTraits<FFCTweenTickFunction> : public TStructOpsTypeTraitsBase2<FFCTweenTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+UCLASS(Config = Game)
 class FCTWEEN_API UFCTweenSubsystem : public UGameInstanceSubsystem, public FTickableGameObject
 {
 	GENERATED_BODY()
@@ -13,12 +42,39 @@ private:
 	UPROPERTY()
 	float LastRealTimeSeconds;
 
+	FFCTweenTickFunction TweenTickFunction;
+
+	FDelegateHandle WorldInitializedActorsHandle;
+	FDelegateHandle WorldCleanupHandle;
+
+	void RegisterTweenTick(UWorld* World);
+	void UnregisterTweenTick();
+	void OnWorldInitializedActors(const UWorld::FActorsInitializedParams& Params);
+	void OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources);
+
 public:
+	/**
+	 * @brief Tick group the tweens are updated in. The default, TG_PostPhysics, runs after input and the pre-physics actor
+	 * ticks and before TG_PostUpdateWork, so a tween started this frame moves its target this frame. Set it in DefaultGame.ini
+	 * under [/Script/FCTween.FCTweenSubsystem] or with SetTickGroup.
+	 */
+	UPROPERTY(Config)
+	TEnumAsByte<ETickingGroup> TickGroup = TG_PostPhysics;
+
 	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
 	virtual void Deinitialize() override;
 
+	UFUNCTION(BlueprintCallable, Category = "Tween")
+	void SetTickGroup(TEnumAsByte<ETickingGroup> InTickGroup);
+
+	/**
+	 * @brief Updates every tween once per frame, whichever of the tick function and the tickable object gets there first
+	 */
+	void UpdateTweens();
+
 	virtual void Tick(float DeltaTime) override;
 	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
 	virtual TStatId GetStatId() const override;
 	virtual bool IsTickableWhenPaused() const override;
 	virtual bool IsTickableInEditor() const override;
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+#include "VRubiksCubeLayout.h"
+#include "VRubiksCubeMesh.h"
+#include "VRubiksCubeModel.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVRubiksCubeMeshMoveTest, "Rubiks.CubeMesh.PieceTransforms", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FVRubiksCubeMeshMoveTest::RunTest(const FString& Parameters)
+{
+	static const float PieceWidth = 100.0f;
+	const FColor FaceColors[6] = { FColor::Red, FColor::Orange, FColor::Blue, FColor::Green, FColor::White, FColor::Yellow };
+
+	for (int32 Size = 2; Size <= 5; Size++) {
+		//Same layout FVRubiksCubeLayout::Get builds, without a piece mesh to read the width from
+		FVRubiksCubeLayout Layout;
+		Layout.Size = Size;
+		Layout.PieceWidth = PieceWidth;
+		Layout.Center = FVector(PieceWidth * (Size - 1) / 2);
+		FVRubiksCubeModel::GetSurfaceCells(Size, Layout.Cells);
+		for (const FIntVector& Cell : Layout.Cells) {
+			Layout.Offsets.Add(FVector(Cell) * PieceWidth);
+			Layout.FaceMasks.Add(FVRubiksCubeLayout::GetFaceMask(Cell, Size));
+		}
+
+		FVRubiksCubeModel Model;
+		Model.Reset(Size);
+		FVRubiksCubeMesh Mesh;
+		Mesh.Build(Layout, FaceColors, FColor::Black);
+		if (!TestEqual(TEXT("Pieces in the mesh"), Mesh.NumPieces(), Model.NumPieces())) {
+			return false;
+		}
+
+		//Solved pieces are not rotated, so each vertex minus its piece offset is where it sits around the piece origin
+		TArray<FVector> LocalVertices = Mesh.Vertices;
+		TArray<FVector> LocalNormals = Mesh.Normals;
+		for (int32 Vertex = 0; Vertex < LocalVertices.Num(); Vertex++) {
+			LocalVertices[Vertex] -= Layout.Offsets[Vertex / FVRubiksCubeMesh::VerticesPerPiece];
+		}
+
+		FRandomStream Random(Size);
+		TArray<int32> SlicePieces;
+		for (int32 Step = 0; Step < 20; Step++) {
+			const FVRubiksMove Move(Random.RandHelper(3), Random.RandHelper(Size), Random.RandBool() ? 1 : -1);
+			Model.GetSlicePieces(Move, SlicePieces);
+			Model.ApplyMove(Move);
+
+			const TArray<FVector> VerticesBefore = Mesh.Vertices;
+			const TArray<FVector> NormalsBefore = Mesh.Normals;
+			for (int32 Piece : SlicePieces) {
+				Mesh.SetPieceTransform(Piece, FTransform(Model.GetPieceRotation(Piece), FVector(Model.GetPiece(Piece).Cell) * PieceWidth));
+			}
+
+			for (int32 Piece = 0; Piece < Model.NumPieces(); Piece++) {
+				const FTransform Transform(Model.GetPieceRotation(Piece), FVector(Model.GetPiece(Piece).Cell) * PieceWidth);
+				const bool bInSlice = SlicePieces.Contains(Piece);
+				for (int32 Corner = 0; Corner < FVRubiksCubeMesh::VerticesPerPiece; Corner++) {
+					const int32 Vertex = Piece * FVRubiksCubeMesh::VerticesPerPiece + Corner;
+					if (!Mesh.Vertices[Vertex].Equals(Transform.TransformPosition(LocalVertices[Vertex]), 0.01f)
+						|| !Mesh.Normals[Vertex].Equals(Transform.TransformVectorNoScale(LocalNormals[Vertex]), 0.001f)) {
+						AddError(FString::Printf(TEXT("%dx%d move %d: piece %d does not match the model"), Size, Size, Step, Piece));
+						return false;
+					}
+					if (!bInSlice && (Mesh.Vertices[Vertex] != VerticesBefore[Vertex] || Mesh.Normals[Vertex] != NormalsBefore[Vertex])) {
+						AddError(FString::Printf(TEXT("%dx%d move %d: piece %d outside the slice was rewritten"), Size, Size, Step, Piece));
+						return false;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+#include "VRubiksLodPolicy.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVRubiksLodPolicySelectTest, "Rubiks.LodPolicy.Select", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FVRubiksLodPolicySelectTest::RunTest(const FString& Parameters)
+{
+	struct FCase
+	{
+		float ScreenSize;
+		EVRubiksPieceLod CurrentLod;
+		EVRubiksPieceLod ExpectedLod;
+	};
+
+	//Default policy: Stickers below 0.02, Faces below 0.006, back up only 25% above those (0.025 and 0.0075)
+	static const FCase Cases[] = {
+		//Shrinking from the full mesh, the thresholds themselves still keep the finer level
+		{ 0.1f, EVRubiksPieceLod::Full, EVRubiksPieceLod::Full },
+		{ 0.02f, EVRubiksPieceLod::Full, EVRubiksPieceLod::Full },
+		{ 0.0199f, EVRubiksPieceLod::Full, EVRubiksPieceLod::Stickers },
+		{ 0.006f, EVRubiksPieceLod::Full, EVRubiksPieceLod::Stickers },
+		{ 0.0059f, EVRubiksPieceLod::Full, EVRubiksPieceLod::Faces },
+
+		//From stickers: inside the band above 0.02 nothing changes, past 0.025 the full mesh comes back
+		{ 0.0201f, EVRubiksPieceLod::Stickers, EVRubiksPieceLod::Stickers },
+		{ 0.0249f, EVRubiksPieceLod::Stickers, EVRubiksPieceLod::Stickers },
+		{ 0.0251f, EVRubiksPieceLod::Stickers, EVRubiksPieceLod::Full },
+		{ 0.0061f, EVRubiksPieceLod::Stickers, EVRubiksPieceLod::Stickers },
+		{ 0.0059f, EVRubiksPieceLod::Stickers, EVRubiksPieceLod::Faces },
+
+		//From faces: inside the band above 0.006 nothing changes, past 0.0075 stickers, past 0.025 the full mesh
+		{ 0.001f, EVRubiksPieceLod::Faces, EVRubiksPieceLod::Faces },
+		{ 0.0061f, EVRubiksPieceLod::Faces, EVRubiksPieceLod::Faces },
+		{ 0.0074f, EVRubiksPieceLod::Faces, EVRubiksPieceLod::Faces },
+		{ 0.0076f, EVRubiksPieceLod::Faces, EVRubiksPieceLod::Stickers },
+		{ 0.0249f, EVRubiksPieceLod::Faces, EVRubiksPieceLod::Stickers },
+		{ 0.0251f, EVRubiksPieceLod::Faces, EVRubiksPieceLod::Full }
+	};
+
+	const FVRubiksLodPolicy Policy;
+	for (const FCase& Case : Cases) {
+		TestEqual(FString::Printf(TEXT("Screen size %.4f from LOD %d"), Case.ScreenSize, (int32)Case.CurrentLod),
+			(int32)Policy.Select(Case.ScreenSize, Case.CurrentLod), (int32)Case.ExpectedLod);
+	}
+
+	//A cube hovering around a threshold switches once, not on every update
+	EVRubiksPieceLod Lod = EVRubiksPieceLod::Full;
+	static const float Hovering[] = { 0.021f, 0.019f, 0.021f, 0.019f, 0.024f, 0.019f };
+	for (float ScreenSize : Hovering) {
+		Lod = Policy.Select(ScreenSize, Lod);
+	}
+	TestEqual(TEXT("LOD after hovering around the stickers threshold"), (int32)Lod, (int32)EVRubiksPieceLod::Stickers);
+	return true;
+}
+
+#endif
@@ -0,0 +1,435 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VRubiks2x2Solver.h"
+#include "RubiksCube.h"
+#include "VRubiksTableFile.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+#include "Tasks/Task.h"
+#include <atomic>
+
+namespace VRubiks2x2Solver
+{
+	static constexpr int32 NumMoves = 9;
+	static constexpr int32 NumPermutations = 5040;
+	static constexpr int32 NumTwists = 729;
+	static constexpr int32 NumStates = FVRubiks2x2Solver::NumStates;
+	static constexpr int32 MaxDistance = 14;
+	static constexpr uint8 Unvisited = 0xFF;
+
+	static const TCHAR* TableFileName = TEXT("TwoByTwoDistances.bin");
+	static constexpr uint32 TableMagic = 0x44324252; //RB2D
+	static constexpr uint16 TableVersion = 1;
+
+	static std::atomic<bool> bTableReady { false };
+	static std::atomic<bool> bTableRequested { false };
+
+	//Move M turns layer 1 of axis M / 3 by one of these
+	static const int8 MoveQuarterTurns[3] = { 1, 2, -1 };
+
+	static FVRubiksMove GetMove(int32 Move)
+	{
+		return FVRubiksMove(Move / 3, 1, MoveQuarterTurns[Move % 3]);
+	}
+
+	/**
+	 * Corners by slot, slot N being cell (N & 1, (N >> 1) & 1, N >> 2). Slot 0 holds the corner that never moves.
+	 * Orientation is which of the slot's faces the cubie's Z sticker is on, the Z face first, the other two in a fixed handedness.
+	 */
+	struct FCorners
+	{
+		uint8 Perm[8];
+		uint8 Ori[8];
+
+		FCorners()
+		{
+			for (uint8 i = 0; i < 8; i++) {
+				Perm[i] = i;
+				Ori[i] = 0;
+			}
+		}
+
+		//Applies Move, a state as well, after this one
+		void Multiply(const FCorners& Move)
+		{
+			FCorners Result;
+			for (int32 i = 0; i < 8; i++) {
+				Result.Perm[i] = Perm[Move.Perm[i]];
+				Result.Ori[i] = (Ori[Move.Perm[i]] + Move.Ori[i]) % 3;
+			}
+			*this = Result;
+		}
+
+		//Order of the corners in slots 1-7
+		int32 GetPermutation() const
+		{
+			int32 Index = 0;
+			for (int32 i = 1; i < 8; i++) {
+				int32 Smaller = 0;
+				for (int32 j = i + 1; j < 8; j++) {
+					Smaller += Perm[j] < Perm[i];
+				}
+				Index = Index * (8 - i) + Smaller;
+			}
+			return Index;
+		}
+
+		void SetPermutation(int32 Index)
+		{
+			int32 Digits[8];
+			for (int32 i = 7; i >= 1; i--) {
+				Digits[i] = Index % (8 - i);
+				Index /= 8 - i;
+			}
+
+			bool bUsed[8] = { true };
+			for (int32 i = 1; i < 8; i++) {
+				int32 Value = 1;
+				for (int32 Skip = Digits[i]; bUsed[Value] || Skip > 0; Value++) {
+					Skip -= !bUsed[Value];
+				}
+				bUsed[Value] = true;
+				Perm[i] = (uint8)Value;
+			}
+		}
+
+		//Twists of slots 1-6, slot 7 follows from the sum
+		int32 GetTwist() const
+		{
+			int32 Twist = 0;
+			for (int32 i = 1; i < 7; i++) {
+				Twist = Twist * 3 + Ori[i];
+			}
+			return Twist;
+		}
+
+		void SetTwist(int32 Twist)
+		{
+			int32 Sum = 0;
+			for (int32 i = 6; i >= 1; i--) {
+				Ori[i] = (uint8)(Twist % 3);
+				Sum += Ori[i];
+				Twist /= 3;
+			}
+			Ori[7] = (uint8)((3 - Sum % 3) % 3);
+		}
+
+		static FIntVector GetSlotDirection(int32 Slot)
+		{
+			return FIntVector((Slot & 1) * 2 - 1, ((Slot >> 1) & 1) * 2 - 1, (Slot >> 2) * 2 - 1);
+		}
+
+		//Reads a 2x2 model in the frame where the fixed corner is home. OutFrame turns that frame into the model's
+		static bool FromModel(const FVRubiksCubeModel& Model, FCorners& OutCorners, uint8& OutFrame)
+		{
+			if (Model.GetSize() != 2) {
+				return false;
+			}
+
+			//Cells and directions in doubled coordinates around the center, so each component is -1 or 1
+			int32 Frame = INDEX_NONE;
+			for (int32 Index = 0; Index < Model.NumPieces(); Index++) {
+				if (Model.GetPiece(Index).HomeCell == FIntVector(0)) {
+					Frame = Model.GetPiece(Index).Orientation;
+				}
+			}
+			if (Frame == INDEX_NONE) {
+				return false;
+			}
+			const uint8 ToSolverFrame = FVRubiksCubeModel::InverseOrientation((uint8)Frame);
+
+			uint8 Seen = 0;
+			for (int32 Slot = 0; Slot < 8; Slot++) {
+				const FIntVector Direction = GetSlotDirection(Slot);
+				const int32 PieceIndex = Model.GetPieceAtCell((FVRubiksCubeModel::RotateByOrientation((uint8)Frame, Direction) + FIntVector(1)) / 2);
+				if (PieceIndex == INDEX_NONE) {
+					return false;
+				}
+
+				const FVRubiksCubeModel::FPiece& Piece = Model.GetPiece(PieceIndex);
+				const int32 Cubie = Piece.HomeCell.X + Piece.HomeCell.Y * 2 + Piece.HomeCell.Z * 4;
+				Seen |= 1 << Cubie;
+
+				//Faces of the slot: Z first, then X and Y ordered so (Z, n1, n2) is right handed
+				const bool bRightHanded = Direction.X * Direction.Y * Direction.Z > 0;
+				const FIntVector Faces[3] = {
+					FIntVector(0, 0, Direction.Z),
+					bRightHanded ? FIntVector(Direction.X, 0, 0) : FIntVector(0, Direction.Y, 0),
+					bRightHanded ? FIntVector(0, Direction.Y, 0) : FIntVector(Direction.X, 0, 0)
+				};
+				const FIntVector Sticker(0, 0, Piece.HomeCell.Z * 2 - 1);
+				const FIntVector StickerDirection = FVRubiksCubeModel::RotateByOrientation(ToSolverFrame, FVRubiksCubeModel::RotateByOrientation(Piece.Orientation, Sticker));
+				OutCorners.Perm[Slot] = (uint8)Cubie;
+				OutCorners.Ori[Slot] = StickerDirection == Faces[0] ? 0 : (StickerDirection == Faces[1] ? 1 : 2);
+			}
+
+			int32 TwistSum = 0;
+			for (int32 Slot = 0; Slot < 8; Slot++) {
+				TwistSum += OutCorners.Ori[Slot];
+			}
+			OutFrame = (uint8)Frame;
+			return Seen == 0xFF && OutCorners.Perm[0] == 0 && OutCorners.Ori[0] == 0 && TwistSum % 3 == 0;
+		}
+	};
+
+	/**
+	 * Move tables for both coordinates ([Coordinate * 9 + Move]), always derived from the model,
+	 * and the distances modulo 3 (4 states per byte, 3 = not reached), mapped from the file when it matches them.
+	 */
+	struct FTable
+	{
+		uint16 PermutationMove[NumPermutations * NumMoves];
+		uint16 TwistMove[NumTwists * NumMoves];
+
+		const uint8* Distances;
+
+		FVRubiksTableFile File;
+
+		//Only used when the table was built by this process
+		TArray<uint8> Storage;
+
+		FTable()
+		{
+			const double StartTime = FPlatformTime::Seconds();
+
+			FCorners Moves[NumMoves];
+			FVRubiksCubeModel Model;
+			for (int32 Move = 0; Move < NumMoves; Move++) {
+				Model.Reset(2);
+				Model.ApplyMove(GetMove(Move));
+				uint8 Frame = 0;
+				verify(FCorners::FromModel(Model, Moves[Move], Frame) && Frame == 0);
+			}
+
+			for (int32 Permutation = 0; Permutation < NumPermutations; Permutation++) {
+				FCorners Corners;
+				Corners.SetPermutation(Permutation);
+				for (int32 Move = 0; Move < NumMoves; Move++) {
+					FCorners Moved = Corners;
+					Moved.Multiply(Moves[Move]);
+					PermutationMove[Permutation * NumMoves + Move] = (uint16)Moved.GetPermutation();
+				}
+			}
+			for (int32 Twist = 0; Twist < NumTwists; Twist++) {
+				FCorners Corners;
+				Corners.SetTwist(Twist);
+				for (int32 Move = 0; Move < NumMoves; Move++) {
+					FCorners Moved = Corners;
+					Moved.Multiply(Moves[Move]);
+					TwistMove[Twist * NumMoves + Move] = (uint16)Moved.GetTwist();
+				}
+			}
+
+			const int64 PayloadSize = (NumStates + 3) / 4;
+			const uint32 Fingerprint = FCrc::MemCrc32(Moves, sizeof(Moves));
+			if (File.Map(TableFileName, TableMagic, TableVersion, Fingerprint, PayloadSize)) {
+				Distances = File.GetPayload();
+				UE_LOG(LogRubiks, Log, TEXT("2x2 distance table mapped in %.2f ms"), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+				return;
+			}
+
+			Build(Storage);
+			Distances = Storage.GetData();
+			const bool bSaved = FVRubiksTableFile::Write(TableFileName, TableMagic, TableVersion, Fingerprint, Storage.GetData(), PayloadSize);
+			UE_LOG(LogRubiks, Log, TEXT("2x2 distance table built in %.0f ms%s"), (FPlatformTime::Seconds() - StartTime) * 1000.0, bSaved ? TEXT(" and saved") : TEXT(""));
+		}
+
+		int32 ApplyMove(int32 State, int32 Move) const
+		{
+			return PermutationMove[(State / NumTwists) * NumMoves + Move] * NumTwists + TwistMove[(State % NumTwists) * NumMoves + Move];
+		}
+
+		int32 GetDistanceMod3(int32 State) const
+		{
+			return (Distances[State >> 2] >> ((State & 3) * 2)) & 3;
+		}
+
+		/**
+		 * Breadth first, one parallel pass per depth. Each pass pulls instead of pushing: every unreached state looks for a
+		 * neighbor at the current depth (the moves are closed under inverse), so a worker only ever writes its own states.
+		 * New states go to a separate layer until the pass is over, full bytes are packed to 2 bits at the end.
+		 */
+		void Build(TArray<uint8>& OutPacked) const
+		{
+			TArray<uint8> Depths;
+			Depths.Init(Unvisited, NumStates);
+			Depths[0] = 0;
+
+			TArray<uint8> Reached;
+			Reached.SetNumZeroed(NumStates);
+
+			const int32 ChunkSize = 16384;
+			const int32 NumChunks = (NumStates + ChunkSize - 1) / ChunkSize;
+			for (uint8 Depth = 0; Depth < MaxDistance; Depth++) {
+				std::atomic<int32> NumReached { 0 };
+				ParallelFor(NumChunks, [this, &Depths, &Reached, &NumReached, Depth, ChunkSize](int32 Chunk)
+				{
+					int32 ChunkReached = 0;
+					const int32 End = FMath::Min((Chunk + 1) * ChunkSize, NumStates);
+					for (int32 State = Chunk * ChunkSize; State < End; State++) {
+						if (Depths[State] != Unvisited) {
+							continue;
+						}
+						for (int32 Move = 0; Move < NumMoves; Move++) {
+							if (Depths[ApplyMove(State, Move)] == Depth) {
+								Reached[State] = 1;
+								ChunkReached++;
+								break;
+							}
+						}
+					}
+					NumReached += ChunkReached;
+				});
+
+				if (NumReached == 0) {
+					break;
+				}
+				ParallelFor(NumChunks, [&Depths, &Reached, Depth, ChunkSize](int32 Chunk)
+				{
+					const int32 End = FMath::Min((Chunk + 1) * ChunkSize, NumStates);
+					for (int32 State = Chunk * ChunkSize; State < End; State++) {
+						if (Reached[State]) {
+							Depths[State] = Depth + 1;
+							Reached[State] = 0;
+						}
+					}
+				});
+			}
+
+			OutPacked.SetNumZeroed((NumStates + 3) / 4);
+			for (int32 State = 0; State < NumStates; State++) {
+				const uint8 Value = Depths[State] == Unvisited ? 3 : Depths[State] % 3;
+				OutPacked[State >> 2] |= Value << ((State & 3) * 2);
+			}
+		}
+
+		//Optimal moves from State, as move indices
+		void Solve(int32 State, TArray<int32>& OutMoves) const
+		{
+			OutMoves.Reset();
+			while (State != 0 && OutMoves.Num() < MaxDistance) {
+				const int32 Closer = (GetDistanceMod3(State) + 2) % 3;
+				int32 Move = 0;
+				for (; Move < NumMoves; Move++) {
+					const int32 Next = ApplyMove(State, Move);
+					if (GetDistanceMod3(Next) == Closer) {
+						OutMoves.Add(Move);
+						State = Next;
+						break;
+					}
+				}
+				check(Move < NumMoves);
+			}
+		}
+	};
+
+	static const FTable& GetTable()
+	{
+		static const FTable Table;
+		bTableReady = true;
+		return Table;
+	}
+
+	static bool GetState(const FVRubiksCubeModel& Model, int32& OutState, uint8& OutFrame)
+	{
+		FCorners Corners;
+		if (!FCorners::FromModel(Model, Corners, OutFrame)) {
+			return false;
+		}
+		OutState = Corners.GetPermutation() * NumTwists + Corners.GetTwist();
+		return true;
+	}
+
+	//Number of states at each distance and the cost of a query, the counts are known (1, 9, 54, 321 ... 2644)
+	static void PrintDistances()
+	{
+		const FTable& Table = GetTable();
+
+		int64 Counts[MaxDistance + 1] = {};
+		FRandomStream Random(0x52424B32);
+		TArray<int32> Moves;
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Query = 0; Query < 100000; Query++) {
+			Table.Solve(Random.RandHelper(NumStates), Moves);
+			Counts[Moves.Num()]++;
+		}
+		const double QuerySeconds = (FPlatformTime::Seconds() - StartTime) / 100000;
+
+		for (int32 Distance = 0; Distance <= MaxDistance; Distance++) {
+			if (Counts[Distance] > 0) {
+				UE_LOG(LogRubiks, Display, TEXT("2x2 distance %d: %.3f%% of 100000 random states"), Distance, Counts[Distance] / 1000.0);
+			}
+		}
+		UE_LOG(LogRubiks, Display, TEXT("2x2 optimal solve: %.2f us per query"), QuerySeconds * 1000000.0);
+	}
+
+	static FAutoConsoleCommand PrintDistancesCommand(
+		TEXT("Rubiks.TwoByTwoDistances"),
+		TEXT("Solves random 2x2 states from the distance table and logs how far they were and how long a query takes."),
+		FConsoleCommandDelegate::CreateStatic(&PrintDistances));
+}
+
+bool FVRubiks2x2Solver::SolveModel(const FVRubiksCubeModel& Model, TArray<FVRubiksMove>& OutMoves)
+{
+	using namespace VRubiks2x2Solver;
+
+	OutMoves.Reset();
+	int32 State = 0;
+	uint8 Frame = 0;
+	if (!GetState(Model, State, Frame)) {
+		return false;
+	}
+
+	TArray<int32> Moves;
+	GetTable().Solve(State, Moves);
+	for (int32 Move : Moves) {
+		OutMoves.Add(FVRubiksCubeModel::ReorientMove(GetMove(Move), Frame, 2));
+	}
+	return true;
+}
+
+int32 FVRubiks2x2Solver::GetDistance(const FVRubiksCubeModel& Model)
+{
+	using namespace VRubiks2x2Solver;
+
+	int32 State = 0;
+	uint8 Frame = 0;
+	if (!GetState(Model, State, Frame)) {
+		return INDEX_NONE;
+	}
+
+	const FTable& Table = GetTable();
+	int32 Distance = 0;
+	for (; State != 0 && Distance < MaxDistance; Distance++) {
+		const int32 Closer = (Table.GetDistanceMod3(State) + 2) % 3;
+		for (int32 Move = 0; Move < NumMoves; Move++) {
+			const int32 Next = Table.ApplyMove(State, Move);
+			if (Table.GetDistanceMod3(Next) == Closer) {
+				State = Next;
+				break;
+			}
+		}
+	}
+	return Distance;
+}
+
+void FVRubiks2x2Solver::BuildTable()
+{
+	VRubiks2x2Solver::GetTable();
+}
+
+void FVRubiks2x2Solver::BuildTableAsync()
+{
+	if (!VRubiks2x2Solver::bTableRequested.exchange(true)) {
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, []()
+		{
+			VRubiks2x2Solver::GetTable();
+		});
+	}
+}
+
+bool FVRubiks2x2Solver::IsTableReady()
+{
+	return VRubiks2x2Solver::bTableReady;
+}
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VRubiksColorScheme.h"
+#include "Engine/World.h"
+#include "Materials/MaterialParameterCollection.h"
+#include "Materials/MaterialParameterCollectionInstance.h"
+
+TArray<FLinearColor> UVRubiksColorSchemeLibrary::GetSchemeColors(EVRubiksColorScheme Scheme)
+{
+	switch (Scheme)
+	{
+	case EVRubiksColorScheme::ColorBlind:
+		//Okabe-Ito colors, told apart with every common color vision deficiency
+		return {
+			FLinearColor(FColor(0, 114, 178)), //Front: blue
+			FLinearColor(FColor(0, 158, 115)), //Back: bluish green
+			FLinearColor(FColor(230, 159, 0)), //Left: orange
+			FLinearColor(FColor(204, 121, 167)), //Right: reddish purple
+			FLinearColor(1.0f, 1.0f, 1.0f), //Up: white
+			FLinearColor(FColor(240, 228, 66)) //Down: yellow
+		};
+	case EVRubiksColorScheme::HighContrast:
+		return {
+			FLinearColor(0.0f, 0.0f, 1.0f), //Front: blue
+			FLinearColor(0.0f, 1.0f, 0.0f), //Back: green
+			FLinearColor(1.0f, 0.5f, 0.0f), //Left: orange
+			FLinearColor(1.0f, 0.0f, 0.0f), //Right: red
+			FLinearColor(1.0f, 1.0f, 1.0f), //Up: white
+			FLinearColor(1.0f, 1.0f, 0.0f) //Down: yellow
+		};
+	default:
+		return {
+			FLinearColor(0.0f, 0.2f, 1.0f), //Front: blue
+			FLinearColor(0.0f, 0.6f, 0.1f), //Back: green
+			FLinearColor(1.0f, 0.3f, 0.0f), //Left: orange
+			FLinearColor(0.8f, 0.0f, 0.0f), //Right: red
+			FLinearColor(1.0f, 1.0f, 1.0f), //Up: white
+			FLinearColor(1.0f, 0.85f, 0.0f) //Down: yellow
+		};
+	}
+}
+
+void UVRubiksColorSchemeLibrary::ApplyToPalette(const UObject* WorldContextObject, UMaterialParameterCollection* Palette, const TArray<FLinearColor>& Colors)
+{
+	UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	UMaterialParameterCollectionInstance* PaletteInstance = World && Palette ? World->GetParameterCollectionInstance(Palette) : nullptr;
+	if (!PaletteInstance) {
+		return;
+	}
+
+	for (int32 x = 0; x < FMath::Min(Colors.Num(), 6); x++) {
+		PaletteInstance->SetVectorParameterValue(GetPaletteParameterName(x), Colors[x]);
+	}
+}
+
+FName UVRubiksColorSchemeLibrary::GetPaletteParameterName(int32 Index)
+{
+	static const FName Names[6] = {
+		FName("PaletteColor0"), FName("PaletteColor1"), FName("PaletteColor2"),
+		FName("PaletteColor3"), FName("PaletteColor4"), FName("PaletteColor5")
+	};
+	return Names[Index];
+}
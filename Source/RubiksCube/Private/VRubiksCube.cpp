@@ -2,27 +2,256 @@
 
 
 #include "VRubiksCube.h"
+#include "VRubiksColorScheme.h"
+#include "VRubiksFaceletModel.h"
+#include "VRubiksFaceTexture.h"
+#include "RubiksCube.h"
 #include "FCTween.h"
 #include "VRubiksPiece.h"
+#include "VRubiksPiecePool.h"
+#include "VRubiksSaveGame.h"
+#include "VRubiks2x2Solver.h"
+#include "VRubiksReductionSolver.h"
+#include "VRubiksTwoPhaseSolver.h"
 #include "Camera/CameraComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "ProceduralMeshComponent.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "Engine/Texture2D.h"
+#include "Camera/PlayerCameraManager.h"
+#include "TimerManager.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Kismet/GameplayStatics.h"
+#include "Engine/AssetManager.h"
+#include "EngineUtils.h"
+#include "Engine/StreamableManager.h"
 #include "EnhancedInputComponent.h"
 #include "EnhancedInputSubsystems.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/Histogram.h"
+#include "RenderingThread.h"
+#include "Misc/ScopeLock.h"
+#include "Tasks/Task.h"
+
+DECLARE_CYCLE_STAT(TEXT("Commit Piece Transforms"), STAT_RubiksCommitPieceTransforms, STATGROUP_Rubiks);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Input To Motion Last (ms)"), STAT_RubiksInputToMotionLast, STATGROUP_Rubiks);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Input To Motion 0-8 ms"), STAT_RubiksInputToMotion8, STATGROUP_Rubiks);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Input To Motion 8-17 ms"), STAT_RubiksInputToMotion17, STATGROUP_Rubiks);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Input To Motion 17-33 ms"), STAT_RubiksInputToMotion33, STATGROUP_Rubiks);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Input To Motion 33-50 ms"), STAT_RubiksInputToMotion50, STATGROUP_Rubiks);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Input To Motion 50+ ms"), STAT_RubiksInputToMotionSlow, STATGROUP_Rubiks);
+
+//Shared by a solve's worker task and the cube that started it, the result is guarded by Lock
+struct FVRubiksSolveJob
+{
+	std::atomic<bool> bCancel { false };
+
+	FCriticalSection Lock;
+
+	//Moves found since the cube last took them
+	TArray<FVRubiksMove> Moves;
+
+	bool bFoundSolution = false;
+
+	bool bDone = false;
+};
+
+namespace VRubiksCube
+{
+	//Runs on the worker, picks the solver for the cube size. OnMoves gets the solution in parts as they are found, only
+	//bigger cubes have more than one
+	static bool FindSolution(const FVRubiksCubeModel& Model, float TimeBudget, const std::atomic<bool>& bCancel, TFunctionRef<void(const TArray<FVRubiksMove>&)> OnMoves)
+	{
+		TArray<FVRubiksMove> Moves;
+		bool bFoundSolution = false;
+		if (Model.GetSize() == 2) {
+			bFoundSolution = FVRubiks2x2Solver::SolveModel(Model, Moves);
+		} else if (Model.GetSize() == 3) {
+			FVRubiksTwoPhaseSolver::FSettings Settings;
+			Settings.TimeBudgetSeconds = TimeBudget;
+			Settings.bCancel = &bCancel;
+			bFoundSolution = FVRubiksTwoPhaseSolver::SolveModel(Model, Settings, Moves);
+		} else {
+			FVRubiksReductionSolver::FSettings Settings;
+			Settings.TimeBudgetSeconds = TimeBudget;
+			Settings.bCancel = &bCancel;
+			Settings.OnStageSolved = [&OnMoves](const TArray<FVRubiksMove>& StageMoves)
+			{
+				OnMoves(StageMoves);
+			};
+			return FVRubiksReductionSolver::SolveModel(Model, Settings, Moves);
+		}
+
+		if (bFoundSolution) {
+			OnMoves(Moves);
+		}
+		return bFoundSolution;
+	}
+
+	//Shared by every cube, filled on the render thread and dumped from the console
+	static FCriticalSection LatencyLock;
+
+	static FHistogram& GetLatencyHistogram()
+	{
+		static FHistogram Histogram;
+		if (Histogram.GetNumBins() == 0) {
+			Histogram.InitLinear(0.0, 100.0, 4.0);
+		}
+		return Histogram;
+	}
+
+	//Input times of the turns in the frame the render thread is drawing, render thread only
+	static TArray<double> PendingInputSeconds;
+
+	//Stamps the end of the latency once the render thread has finished the frame the turns first show in
+	static void MeasurePendingInputs()
+	{
+		const double EndFrameSeconds = FPlatformTime::Seconds();
+		for (double InputSeconds : PendingInputSeconds) {
+			const double LatencyMs = (EndFrameSeconds - InputSeconds) * 1000.0;
+			SET_FLOAT_STAT(STAT_RubiksInputToMotionLast, LatencyMs);
+			if (LatencyMs < 8.0) {
+				INC_DWORD_STAT(STAT_RubiksInputToMotion8);
+			} else if (LatencyMs < 17.0) {
+				INC_DWORD_STAT(STAT_RubiksInputToMotion17);
+			} else if (LatencyMs < 33.0) {
+				INC_DWORD_STAT(STAT_RubiksInputToMotion33);
+			} else if (LatencyMs < 50.0) {
+				INC_DWORD_STAT(STAT_RubiksInputToMotion50);
+			} else {
+				INC_DWORD_STAT(STAT_RubiksInputToMotionSlow);
+			}
+
+			FScopeLock Lock(&LatencyLock);
+			GetLatencyHistogram().AddMeasurement(LatencyMs);
+		}
+		PendingInputSeconds.Reset();
+	}
+
+	static void RecordInputToMotion(double InputSeconds)
+	{
+		ENQUEUE_RENDER_COMMAND(RubiksInputToMotion)([InputSeconds](FRHICommandListImmediate&)
+		{
+			//Bound on the render thread, the thread that broadcasts it
+			static const FDelegateHandle EndFrameHandle = FCoreDelegates::OnEndFrameRT.AddStatic(&MeasurePendingInputs);
+			PendingInputSeconds.Add(InputSeconds);
+		});
+	}
+
+	static void DumpInputLatency()
+	{
+		FScopeLock Lock(&LatencyLock);
+		FHistogram& Histogram = GetLatencyHistogram();
+		UE_LOG(LogRubiks, Display, TEXT("Input to motion: %d turns, %.1f ms average, %.1f ms min, %.1f ms max"),
+			(int32)Histogram.GetNumMeasurements(), Histogram.GetAverageOfAllMeasures(), Histogram.GetMinOfAllMeasures(), Histogram.GetMaxOfAllMeasures());
+		Histogram.DumpToLog(TEXT("Rubiks input to motion (ms)"));
+	}
+
+	static FAutoConsoleCommand DumpInputLatencyCommand(
+		TEXT("Rubiks.DumpInputLatency"),
+		TEXT("Logs the histogram of the time from the input that starts a turn to the end of the first frame the render thread draws the turn in."),
+		FConsoleCommandDelegate::CreateStatic(&DumpInputLatency));
+
+	static void RunStartupBenchmark(const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 NumRuns = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 5;
+		for (TActorIterator<AVRubiksCube> It(World); It; ++It) {
+			It->BenchmarkStartup(NumRuns);
+		}
+	}
+
+	static FAutoConsoleCommand StartupBenchmarkCommand(
+		TEXT("Rubiks.StartupBenchmark"),
+		TEXT("Restarts every cube from its soft references and logs the time to assets ready and to interactive. Assets still referenced elsewhere (pooled pieces) stay in memory, compare with the cold start logged after BeginPlay. Usage: Rubiks.StartupBenchmark [Runs=5]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunStartupBenchmark));
+}
+
+void FVRubiksTransformCommitTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target && IsValidChecked(Target)) {
+		Target->CommitPieceTransforms();
+	}
+}
+
+FString FVRubiksTransformCommitTickFunction::DiagnosticMessage()
+{
+	return Target ? Target->GetFullName() + TEXT("[CommitPieceTransforms]") : TEXT("<null>[CommitPieceTransforms]");
+}
 
 // Sets default values
 AVRubiksCube::AVRubiksCube()
 {
-	PrimaryActorTick.bCanEverTick = false;
+	//Only ticks while a build is pending or pieces are being generated
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	//Runs after the tweens (updated by their subsystem) and only while a slice turns
+	TransformCommitTick.bCanEverTick = true;
+	TransformCommitTick.bStartWithTickEnabled = false;
+	TransformCommitTick.TickGroup = TG_PostUpdateWork;
+	SliceRotation = FQuat::Identity;
+	bIsSliceDirty = false;
 
 	ScrambleCounter = 0;
 	Steps = 0;
+	PieceSideWidth = 0.0f;
+	bIsGenerating = false;
+	bIsIncomplete = false;
+	bIsBuildPending = false;
+	GenerationCursor = 0;
+	GenerationBudgetMs = 4.0f;
+	TimerStartSeconds = 0.0f;
+	bEnableMoveJournal = true;
+	bAreAssetsLoaded = false;
+	StartupSeconds = 0.0;
+	StartupBenchmarkRuns = 0;
+	PoolPrewarmCount = 0;
 	
 	Size = 3; //Set default cube size
 	bIsInteractionEnabled = true;
 
-	ClickedPiece = nullptr;
+	PieceBackend = EVRubiksPieceBackend::Actors;
+	ActiveBackend = EVRubiksPieceBackend::Actors;
+	InstanceComponentForFaceMask.Init(INDEX_NONE, 64);
+	PieceMeshComponent = nullptr;
+	PieceMeshMaterial = nullptr;
+	bIsPieceMeshDirty = false;
+	StickerMaterial = nullptr;
+	PaletteCollection = nullptr;
+	StickerMaterialInstance = nullptr;
+	FacePaletteIndices = { 0, 1, 2, 3, 4, 5 };
+	FaceColors = UVRubiksColorSchemeLibrary::GetSchemeColors(EVRubiksColorScheme::Standard);
+
+	CurrentLod = EVRubiksPieceLod::Full;
+	TargetLod = EVRubiksPieceLod::Full;
+	LodSwitchCursor = 0;
+	StickerLodMesh = nullptr;
+	FaceLodMaterial = nullptr;
+	FaceLodComponent = nullptr;
+	FaceLodSize = 0;
+	LodUpdateInterval = 0.25f;
+	LodSwitchBatchSize = 256;
+
+	ClickedPieceIndex = INDEX_NONE;
     bIsCameraMoving = false;
+	bIsInteractPending = false;
+	InteractInputSeconds = 0.0;
+	TurnInputSeconds = 0.0;
+	bIsDragTurning = false;
+	DragAngle = 0.0f;
+	DragDirection = FVector::ZeroVector;
+	SnapTween = nullptr;
+	IntroTween = nullptr;
+	TurnTween = nullptr;
+	SnapDuration = 0.12f;
+	DragPiecesPerQuarterTurn = 2.0f;
+	bAnimateSolution = true;
+	SolutionCursor = 0;
+	bIsPlayingSolution = false;
+	bIsWaitingForSolution = false;
+	SolveTimeBudget = 1.0f;
+	SolutionMoveDuration = 0.2f;
 	
 	DummySceneComponent = CreateDefaultSubobject <USceneComponent>(FName("Dummy Root"));
 	SetRootComponent(DummySceneComponent);
@@ -45,184 +274,1176 @@ AVRubiksCube::AVRubiksCube()
 void AVRubiksCube::SetSize(int32 NewSize)
 {
 	Size = FMath::Clamp(NewSize, 2, 16);
-	Build();
+	RequestBuild();
+}
+
+void AVRubiksCube::RequestBuild()
+{
+	//Coalesced into a single Build on the next tick
+	bIsBuildPending = true;
+	UpdateTickEnabled();
+}
+
+bool AVRubiksCube::IsBuildPending()
+{
+	return bIsBuildPending;
 }
 
+void AVRubiksCube::UpdateTickEnabled()
+{
+	SetActorTickEnabled(bIsGenerating || bIsBuildPending || bIsInteractPending || CurrentLod != TargetLod || SolveJob.IsValid());
+}
+
+#if WITH_EDITOR
+void AVRubiksCube::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	//Dragging the size slider while playing only rebuilds once per frame
+	if (PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED(AVRubiksCube, Size) && HasActorBegunPlay()) {
+		SetSize(Size);
+	}
+}
+#endif
+
 int32 AVRubiksCube::GetSize()
 {
-	return Size;
+	return Size;
+}
+
+void AVRubiksCube::Build()
+{
+	//Nothing to build with yet, OnAssetsLoaded builds the cube
+	if (!bAreAssetsLoaded) {
+		bIsBuildPending = false;
+		UpdateTickEnabled();
+		return;
+	}
+	bIsBuildPending = false;
+
+	//The 2x2 distance table takes about a second to build the first time, map or build it before anyone asks
+	if (Size == 2) {
+		FVRubiks2x2Solver::BuildTableAsync();
+	}
+
+	//Stop this cube's tweening animations, other actors keep theirs
+	StopTweens();
+	bIsSliceDirty = false;
+	TurnInputSeconds = 0.0;
+	bIsDragTurning = false;
+	TransformCommitTick.SetTickFunctionEnable(false);
+	SetActorScale3D(FVector::OneVector);
+	CancelSolve();
+	bIsPlayingSolution = false;
+	bIsScrambling = false;
+	bIsAnimating = false;
+
+	OnCubeChanged.Broadcast(0);
+	if (!bIsGenerating && Model.GetSize() == Size && ActiveBackend == PieceBackend && GetNumGeneratedPieces() == Model.NumPieces()) {
+		//Same size: put the existing pieces back in place instead of respawning them
+		ResetPieces();
+		PlayIntroAnimation();
+	} else {
+		//Recreate the cube, the intro animation plays once generation finishes
+		DestroyPieces();
+		GeneratePieces();
+	}
+
+	//A new cube starts a new journal session
+	if (Journal) {
+		Journal->Compact(Model, Steps);
+	}
+}
+
+void AVRubiksCube::PlayIntroAnimation()
+{
+	//Add a little scaling animation
+	if (IntroTween) {
+		IntroTween->Destroy();
+	}
+	IntroTween = FCTween::Play(
+	1.05f,
+	1.0f,
+	[&](float t)
+	{
+		SetActorScale3D(FVector::OneVector * t);
+	},
+	0.3f,
+	EFCEase::OutBack)->SetOnComplete([this]() {
+		IntroTween = nullptr;
+	});
+}
+
+void AVRubiksCube::StopTweens()
+{
+	for (FCTweenInstance** Tween : { &IntroTween, &TurnTween, &SnapTween }) {
+		if (*Tween) {
+			(*Tween)->Destroy();
+			*Tween = nullptr;
+		}
+	}
+}
+
+// Called when the game starts or when spawned
+void AVRubiksCube::BeginPlay()
+{
+	Super::BeginPlay();
+
+	TransformCommitTick.Target = this;
+	TransformCommitTick.RegisterTickFunction(GetLevel());
+
+	StartupSeconds = FPlatformTime::Seconds();
+	RequestAssets();
+}
+
+void AVRubiksCube::RequestAssets()
+{
+	TArray<FSoftObjectPath> AssetPaths;
+	if (!PieceClass.IsNull()) {
+		AssetPaths.Add(PieceClass.ToSoftObjectPath());
+	}
+	for (const TSoftObjectPtr<UMaterialInstance>& Material : FaceMaterials) {
+		if (!Material.IsNull()) {
+			AssetPaths.Add(Material.ToSoftObjectPath());
+		}
+	}
+
+	//Streamed while the menu or intro plays, assets already in memory complete right away
+	if (AssetPaths.Num() > 0) {
+		AssetsHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(AssetPaths, FStreamableDelegate::CreateUObject(this, &AVRubiksCube::OnAssetsLoaded), FStreamableManager::AsyncLoadHighPriority);
+	}
+	if (!AssetsHandle) {
+		OnAssetsLoaded();
+	}
+}
+
+void AVRubiksCube::OnAssetsLoaded()
+{
+	if (bAreAssetsLoaded) {
+		return;
+	}
+	bAreAssetsLoaded = true;
+
+	LoadedPieceClass = PieceClass.Get();
+	LoadedFaceMaterials.Reset(FaceMaterials.Num());
+	for (const TSoftObjectPtr<UMaterialInstance>& Material : FaceMaterials) {
+		LoadedFaceMaterials.Add(Material.Get());
+	}
+	AssetsHandle.Reset();
+	const double AssetsMs = (FPlatformTime::Seconds() - StartupSeconds) * 1000.0;
+	UE_LOG(LogRubiks, Log, TEXT("%s: piece assets ready %.1f ms after BeginPlay"), *GetName(), AssetsMs);
+	if (StartupBenchmarkRuns > 0) {
+		StartupAssetsMs.Add(AssetsMs);
+	}
+
+	if (PoolPrewarmCount > 0) {
+		GetWorld()->GetSubsystem<UVRubiksPiecePool>()->Prewarm(LoadedPieceClass, PoolPrewarmCount);
+	}
+
+	UVRubiksColorSchemeLibrary::ApplyToPalette(this, PaletteCollection, FaceColors);
+
+	//No cheaper representation to switch to, the screen size is never looked at
+	if (StickerLodMesh || FaceLodMaterial) {
+		GetWorldTimerManager().SetTimer(LodTimerHandle, this, &AVRubiksCube::UpdateLod, LodUpdateInterval, true);
+	}
+
+	if (bEnableMoveJournal) {
+		Journal = MakeUnique<FVRubiksMoveJournal>(FPaths::ProjectSavedDir() / TEXT("Rubiks"), GetName());
+
+		//Restore the last session from its snapshot plus the journal tail
+		FVRubiksCubeModel RecoveredModel;
+		int32 RecoveredSteps = 0;
+		if (Journal->Recover(RecoveredModel, RecoveredSteps) && RecoveredModel.GetSize() >= 2 && RecoveredModel.GetSize() <= 16) {
+			RestoreModel(RecoveredModel, RecoveredSteps);
+			return;
+		}
+	}
+
+	Build();
+}
+
+void AVRubiksCube::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (bIsInteractPending) {
+		ProcessInteract();
+	}
+
+	if (SolveJob) {
+		PollSolve();
+	}
+
+	if (bIsBuildPending) {
+		Build();
+	} else if (bIsGenerating) {
+		GenerateNextPieces();
+	} else if (CurrentLod != TargetLod) {
+		SwitchNextPieces();
+	}
+}
+
+void AVRubiksCube::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	//Flushes the pending moves and waits for the writer
+	Journal.Reset();
+	if (SolveJob) {
+		SolveJob->bCancel = true;
+		SolveJob.Reset();
+	}
+	StopTweens();
+	TransformCommitTick.UnRegisterTickFunction();
+	GetWorldTimerManager().ClearTimer(LodTimerHandle);
+	Super::EndPlay(EndPlayReason);
+}
+
+void AVRubiksCube::RestoreModel(const FVRubiksCubeModel& NewModel, int32 NewSteps)
+{
+	//A build still pending from SetSize would wipe the restored model on the next tick, run it now instead
+	if (bIsBuildPending || NewModel.GetSize() != Size || NewModel.GetSize() != Model.GetSize()) {
+		Size = NewModel.GetSize();
+		Build();
+	}
+
+	//While generating, the pieces are synced once they all exist
+	Model = NewModel;
+	Steps = NewSteps;
+	if (!bIsGenerating) {
+		SyncPiecesToModel();
+	}
+
+	if (Journal) {
+		Journal->Compact(Model, Steps);
+	}
+	OnCubeChanged.Broadcast(Steps);
+}
+
+void AVRubiksCube::SyncPiecesToModel()
+{
+	const int32 NumPieces = GetNumGeneratedPieces();
+	for (int32 x = 0; x < NumPieces; x++) {
+		SnapPieceToModel(x);
+	}
+	FlushPieceTransforms();
+
+	if (IsFaceLodActive()) {
+		BuildFaceLod();
+	}
+}
+
+int32 AVRubiksCube::GetNumGeneratedPieces() const
+{
+	switch (ActiveBackend)
+	{
+	case EVRubiksPieceBackend::Instanced:
+		return PieceInstances.Num();
+	case EVRubiksPieceBackend::DynamicMesh:
+		return PieceMesh.NumPieces();
+	default:
+		return Pieces.Num();
+	}
+}
+
+FTransform AVRubiksCube::GetPieceModelTransform(int32 PieceIndex) const
+{
+	return FTransform(Model.GetPieceRotation(PieceIndex), FVector(Model.GetPiece(PieceIndex).Cell) * PieceSideWidth);
+}
+
+void AVRubiksCube::SetPieceTransform(int32 PieceIndex, const FTransform& RelativeTransform)
+{
+	if (ActiveBackend == EVRubiksPieceBackend::Instanced) {
+		const FVRubiksPieceInstance& PieceInstance = PieceInstances[PieceIndex];
+		//Kept until FlushPieceTransforms hands the moved instances over in batches
+		InstanceTransforms[PieceInstance.Component][PieceInstance.Instance] = RelativeTransform;
+		DirtyInstances[PieceInstance.Component][PieceInstance.Instance] = true;
+		DirtyInstanceComponents[PieceInstance.Component] = true;
+	} else if (ActiveBackend == EVRubiksPieceBackend::DynamicMesh) {
+		//Only this piece's vertex range is rewritten, the upload waits for FlushPieceTransforms
+		PieceMesh.SetPieceTransform(PieceIndex, RelativeTransform);
+		bIsPieceMeshDirty = true;
+	} else {
+		//Pieces stay attached to the cube for their whole life, teleporting skips the physics sweep
+		Pieces[PieceIndex]->SetActorRelativeTransform(RelativeTransform, false, nullptr, ETeleportType::TeleportPhysics);
+	}
+}
+
+void AVRubiksCube::SnapPieceToModel(int32 PieceIndex)
+{
+	SetPieceTransform(PieceIndex, GetPieceModelTransform(PieceIndex));
+}
+
+void AVRubiksCube::FlushPieceTransforms()
+{
+	//One batch per run of consecutive moved instances and one render state update per touched component
+	for (TConstSetBitIterator<> It(DirtyInstanceComponents); It; ++It) {
+		const int32 ComponentIndex = It.GetIndex();
+		int32 FirstDirty = INDEX_NONE;
+		int32 LastDirty = INDEX_NONE;
+		for (TConstSetBitIterator<> Bit(DirtyInstances[ComponentIndex]); Bit; ++Bit) {
+			if (FirstDirty != INDEX_NONE && Bit.GetIndex() != LastDirty + 1) {
+				UpdateInstanceRange(ComponentIndex, FirstDirty, LastDirty);
+				FirstDirty = INDEX_NONE;
+			}
+			if (FirstDirty == INDEX_NONE) {
+				FirstDirty = Bit.GetIndex();
+			}
+			LastDirty = Bit.GetIndex();
+		}
+		if (FirstDirty != INDEX_NONE) {
+			UpdateInstanceRange(ComponentIndex, FirstDirty, LastDirty);
+		}
+
+		DirtyInstances[ComponentIndex].Init(false, InstanceTransforms[ComponentIndex].Num());
+		PieceInstanceComponents[ComponentIndex]->MarkRenderStateDirty();
+	}
+	DirtyInstanceComponents.Init(false, PieceInstanceComponents.Num());
+
+	//The dynamic mesh is a single component, one update however many pieces moved
+	if (bIsPieceMeshDirty) {
+		PieceMeshComponent->UpdateMeshSection(0, PieceMesh.Vertices, PieceMesh.Normals, PieceMesh.UVs, PieceMesh.Colors, TArray<FProcMeshTangent>());
+		bIsPieceMeshDirty = false;
+	}
+}
+
+void AVRubiksCube::UpdateInstanceRange(int32 ComponentIndex, int32 FirstInstance, int32 LastInstance)
+{
+	DirtyTransforms.Reset();
+	DirtyTransforms.Append(InstanceTransforms[ComponentIndex].GetData() + FirstInstance, LastInstance - FirstInstance + 1);
+	PieceInstanceComponents[ComponentIndex]->BatchUpdateInstancesTransforms(FirstInstance, DirtyTransforms, false, false, true);
+}
+
+void AVRubiksCube::CommitPieceTransforms()
+{
+	SCOPE_CYCLE_COUNTER(STAT_RubiksCommitPieceTransforms);
+
+	if (!bIsSliceDirty) {
+		return;
+	}
+	bIsSliceDirty = false;
+
+	//First frame the turn shows, measured once the render thread finishes that frame
+	if (TurnInputSeconds > 0.0) {
+		VRubiksCube::RecordInputToMotion(TurnInputSeconds);
+		TurnInputSeconds = 0.0;
+	}
+
+	const FTransform Pivot(SliceRotation, Layout->Center);
+	for (int32 x = 0; x < PiecesToRotate.Num(); x++) {
+		SetPieceTransform(PiecesToRotate[x], SliceStartTransforms[x] * Pivot);
+	}
+	FlushPieceTransforms();
+}
+
+bool AVRubiksCube::PickPiece(const FVector& RayOrigin, const FVector& RayDirection, int32& OutPieceIndex, FVector& OutWorldPosition, FVector& OutWorldNormal) const
+{
+	if (!Layout || bIsGenerating) {
+		return false;
+	}
+
+	//Cube space: the cube is the box around every cell, whatever the pieces look like
+	const FTransform& CubeTransform = GetActorTransform();
+	const FVector Origin = CubeTransform.InverseTransformPosition(RayOrigin);
+	const FVector Direction = CubeTransform.InverseTransformVector(RayDirection);
+	const FVector HalfExtent(PieceSideWidth * Layout->Size / 2);
+	const FVector BoxMin = Layout->Center - HalfExtent;
+	const FVector BoxMax = Layout->Center + HalfExtent;
+
+	//Slab test, the slab entered last is the face the ray goes through
+	float Near = 0.0f;
+	float Far = MAX_flt;
+	int32 HitAxis = INDEX_NONE;
+	for (int32 Axis = 0; Axis < 3; Axis++) {
+		if (FMath::IsNearlyZero(Direction[Axis])) {
+			if (Origin[Axis] < BoxMin[Axis] || Origin[Axis] > BoxMax[Axis]) {
+				return false;
+			}
+			continue;
+		}
+
+		float Enter = (BoxMin[Axis] - Origin[Axis]) / Direction[Axis];
+		float Exit = (BoxMax[Axis] - Origin[Axis]) / Direction[Axis];
+		if (Enter > Exit) {
+			Swap(Enter, Exit);
+		}
+		if (Enter > Near) {
+			Near = Enter;
+			HitAxis = Axis;
+		}
+		Far = FMath::Min(Far, Exit);
+		if (Near > Far) {
+			return false;
+		}
+	}
+
+	//No entry face when the ray starts inside the cube
+	if (HitAxis == INDEX_NONE) {
+		return false;
+	}
+
+	const FVector LocalPoint = Origin + Direction * Near;
+	const bool bPositive = Direction[HitAxis] < 0;
+	FIntVector Cell;
+	for (int32 Axis = 0; Axis < 3; Axis++) {
+		Cell[Axis] = FMath::Clamp(FMath::FloorToInt((LocalPoint[Axis] - BoxMin[Axis]) / PieceSideWidth), 0, Layout->Size - 1);
+	}
+	Cell[HitAxis] = bPositive ? Layout->Size - 1 : 0;
+
+	FVector LocalNormal(0);
+	LocalNormal[HitAxis] = bPositive ? 1 : -1;
+
+	OutPieceIndex = Model.GetPieceAtCell(Cell);
+	OutWorldPosition = CubeTransform.TransformPosition(LocalPoint);
+	OutWorldNormal = CubeTransform.TransformVectorNoScale(LocalNormal);
+	return OutPieceIndex != INDEX_NONE;
+}
+
+void AVRubiksCube::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
+{
+	Super::SetupPlayerInputComponent(PlayerInputComponent);
+	
+	APlayerController* PC = Cast<APlayerController>(GetController());
+	if (UEnhancedInputLocalPlayerSubsystem* Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(PC->GetLocalPlayer()))
+	{
+		Subsystem->ClearAllMappings();
+		Subsystem->AddMappingContext(DefaultMappingContext, 0);
+	}
+	
+	if (UEnhancedInputComponent* PlayerEnhancedInputComponent = Cast<UEnhancedInputComponent>(PlayerInputComponent))
+	{
+		if (InteractAction)
+		{
+			PlayerEnhancedInputComponent->BindAction(InteractAction, ETriggerEvent::Triggered, this, &AVRubiksCube::Input_Interact);
+			PlayerEnhancedInputComponent->BindAction(InteractAction, ETriggerEvent::Completed, this, &AVRubiksCube::Input_EndInteract);
+		}
+	}
+}
+
+void AVRubiksCube::DestroyPieces()
+{
+	PiecesToRotate.Empty();
+
+	//Pooled pieces and reused components go back with the full mesh, the new cube picks its LOD again
+	ResetLod();
+
+	//Park the pieces in the pool, the next GeneratePieces takes them back
+	UVRubiksPiecePool* Pool = GetWorld() ? GetWorld()->GetSubsystem<UVRubiksPiecePool>() : nullptr;
+	for (int32 x = 0; x < Pieces.Num(); x++) {
+		if (Pool) {
+			Pool->Release(Pieces[x]);
+		} else {
+			Pieces[x]->Destroy();
+		}
+	}
+
+	Pieces.Empty();
+
+	//Instance components stay alive for the next build, only their instances go away
+	for (int32 x = 0; x < PieceInstanceComponents.Num(); x++) {
+		PieceInstanceComponents[x]->ClearInstances();
+		InstancePieces[x].Reset();
+		InstanceTransforms[x].Reset();
+		DirtyInstances[x].Init(false, 0);
+	}
+	PieceInstances.Reset();
+
+	if (PieceMeshComponent) {
+		PieceMeshComponent->ClearAllMeshSections();
+	}
+	PieceMesh.Reset();
+	bIsPieceMeshDirty = false;
+}
+
+void AVRubiksCube::ResetPieces()
+{
+	Steps = 0;
+	Model.ResetToSolved();
+	History.Reset();
+	ResetTimer();
+
+	//Materials follow the home cell, so only the transforms need to change
+	PiecesToRotate.Empty();
+	SyncPiecesToModel();
+}
+
+void AVRubiksCube::GeneratePieces()
+{
+	//Set new cube size
+	Steps = 0;
+	Model.Reset(Size);
+	History.Reset();
+	ResetTimer();
+
+	//Cached per size and piece mesh, shared with every other cube
+	Layout = FVRubiksCubeLayout::Get(Size, LoadedPieceClass ? GetDefault<AVRubiksPiece>(LoadedPieceClass)->GetStaticMesh() : nullptr);
+	PieceSideWidth = Layout->PieceWidth;
+
+	//Set PieceRotator and camera's arm to the center of the new cube
+	float CubeSideWidth = PieceSideWidth * GetSize();
+	
+	RotatorSceneComponent->SetRelativeLocation(Layout->Center);
+	SpringArmComponent->SetRelativeLocation(Layout->Center);
+	SpringArmComponent->SetRelativeRotation(FRotator(-30, 0, 0));
+	SpringArmComponent->AddWorldRotation(FRotator(0, -45, 0));
+	SpringArmComponent->TargetArmLength = CubeSideWidth * 2;
+
+	//The cube stays non-interactive until every piece exists
+	ActiveBackend = PieceBackend;
+	GenerationCursor = 0;
+	bIsGenerating = true;
+	UpdateTickEnabled();
+	OnCubeGenerationProgress.Broadcast(0.0f);
+	GenerateNextPieces();
+}
+
+void AVRubiksCube::GenerateNextPieces()
+{
+	if (ActiveBackend == EVRubiksPieceBackend::Instanced) {
+		//Instances are cheap enough to add in one go
+		GenerateInstances();
+		FinishGeneration();
+		return;
+	}
+
+	if (ActiveBackend == EVRubiksPieceBackend::DynamicMesh) {
+		GeneratePieceMesh();
+		FinishGeneration();
+		return;
+	}
+
+	UWorld * World = GetWorld();
+	UVRubiksPiecePool * Pool = World ? World->GetSubsystem<UVRubiksPiecePool>() : nullptr;
+	if (!Pool) {
+		UE_LOG(LogRubiks, Error, TEXT("%s: no piece pool in this world, generation aborted"), *GetName());
+		AbortGeneration();
+		return;
+	}
+
+	//Always place at least one piece per frame, then keep going while the budget allows it
+	const double StartTime = FPlatformTime::Seconds();
+	const double Budget = GenerationBudgetMs / 1000.0;
+	while (GenerationCursor < Layout->Cells.Num()) {
+		//The layout only lists the pieces that belong to a wall, in model order
+
+		//Take a rubiks piece from the pool (spawned only when the pool is empty)
+		AVRubiksPiece * NewPiece = Pool->Acquire(LoadedPieceClass, this);
+		if (!NewPiece) {
+			//The cube stays incomplete and inert rather than indexing pieces that do not exist
+			UE_LOG(LogRubiks, Error, TEXT("%s: could not spawn piece %d of %d, generation aborted"), *GetName(), GenerationCursor, Layout->Cells.Num());
+			AbortGeneration();
+			return;
+		}
+		NewPiece->AttachToActor(this, FAttachmentTransformRules::KeepRelativeTransform, NAME_None);
+		NewPiece->SetActorRelativeTransform(FTransform(Layout->Offsets[GenerationCursor]));
+		NewPiece->Tags.AddUnique(PIECE_TAG);
+
+		UpdatePieceMaterials(NewPiece, Layout->FaceMasks[GenerationCursor]);
+		Pieces.Add(NewPiece);
+		GenerationCursor++;
+
+		if (FPlatformTime::Seconds() - StartTime >= Budget) {
+			break;
+		}
+	}
+
+	if (GenerationCursor >= Layout->Cells.Num()) {
+		FinishGeneration();
+	} else {
+		OnCubeGenerationProgress.Broadcast((float)GenerationCursor / Layout->Cells.Num());
+	}
+}
+
+UInstancedStaticMeshComponent* AVRubiksCube::GetInstanceComponent(uint8 FaceMask, int32& OutComponentIndex)
+{
+	const AVRubiksPiece* PieceDefaults = GetDefault<AVRubiksPiece>(LoadedPieceClass);
+	UStaticMesh* PieceMesh = PieceDefaults->GetStaticMesh();
+
+	//With the sticker material every piece shares one component, its faces come from the custom data
+	const bool bUseStickerData = UsesStickerCustomData();
+	const uint8 ComponentKey = bUseStickerData ? STICKER_COMPONENT_KEY : FaceMask;
+
+	OutComponentIndex = InstanceComponentForFaceMask[ComponentKey];
+	if (OutComponentIndex != INDEX_NONE) {
+		UInstancedStaticMeshComponent* Component = PieceInstanceComponents[OutComponentIndex];
+		if (Component->GetStaticMesh() != PieceMesh) {
+			Component->SetStaticMesh(PieceMesh);
+		}
+		return Component;
+	}
+
+	//Same materials as a piece actor with these faces: the piece defaults, then the face materials on top
+	UInstancedStaticMeshComponent* Component = NewObject<UInstancedStaticMeshComponent>(this);
+	Component->SetStaticMesh(PieceMesh);
+	Component->SetupAttachment(GetRootComponent());
+	Component->ComponentTags.Add(PIECE_TAG);
+	Component->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	for (int32 Slot = 0; Slot < PieceDefaults->GetMeshComponent()->GetNumMaterials(); Slot++) {
+		Component->SetMaterial(Slot, PieceDefaults->GetMeshComponent()->GetMaterial(Slot));
+	}
+	if (bUseStickerData) {
+		Component->NumCustomDataFloats = 6;
+		for (int32 Face = 0; Face < 6; Face++) {
+			Component->SetMaterial(Face, GetStickerMaterialInstance());
+		}
+	} else {
+		for (int32 Face = 0; Face < 6; Face++) {
+			if (FaceMask & (1 << Face)) {
+				Component->SetMaterial(Face, LoadedFaceMaterials[Face]);
+			}
+		}
+	}
+	Component->RegisterComponent();
+
+	OutComponentIndex = PieceInstanceComponents.Add(Component);
+	InstancePieces.AddDefaulted();
+	InstanceTransforms.AddDefaulted();
+	DirtyInstances.AddDefaulted();
+	InstanceComponentForFaceMask[ComponentKey] = OutComponentIndex;
+	return Component;
+}
+
+void AVRubiksCube::GenerateInstances()
+{
+	//Gather the transforms per component, then add them in one call each
+	PieceInstances.SetNumUninitialized(Layout->Cells.Num());
+	for (int32 x = 0; x < Layout->Cells.Num(); x++) {
+		int32 ComponentIndex = INDEX_NONE;
+		GetInstanceComponent(Layout->FaceMasks[x], ComponentIndex);
+
+		PieceInstances[x].Component = ComponentIndex;
+		PieceInstances[x].Instance = InstancePieces[ComponentIndex].Add(x);
+		InstanceTransforms[ComponentIndex].Add(FTransform(Layout->Offsets[x]));
+	}
+
+	for (int32 x = 0; x < InstanceTransforms.Num(); x++) {
+		if (InstanceTransforms[x].Num() > 0) {
+			PieceInstanceComponents[x]->AddInstances(InstanceTransforms[x], false);
+		}
+		DirtyInstances[x].Init(false, InstanceTransforms[x].Num());
+	}
+
+	DirtyInstanceComponents.Init(false, PieceInstanceComponents.Num());
+	if (UsesStickerCustomData()) {
+		for (int32 x = 0; x < PieceInstances.Num(); x++) {
+			WritePieceStickerData(x);
+		}
+		FlushPieceTransforms();
+	}
+	GenerationCursor = Layout->Cells.Num();
+}
+
+void AVRubiksCube::GeneratePieceMesh()
+{
+	if (!PieceMeshComponent) {
+		PieceMeshComponent = NewObject<UProceduralMeshComponent>(this, FName("Piece Mesh"));
+		PieceMeshComponent->SetupAttachment(GetRootComponent());
+		PieceMeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		PieceMeshComponent->RegisterComponent();
+	}
+
+	FColor StickerColors[6];
+	for (int32 Face = 0; Face < 6; Face++) {
+		StickerColors[Face] = GetFaceColor(Face);
+	}
+	PieceMesh.Build(*Layout, StickerColors, FColor::Black);
+
+	PieceMeshComponent->CreateMeshSection(0, PieceMesh.Vertices, PieceMesh.Triangles, PieceMesh.Normals, PieceMesh.UVs, PieceMesh.Colors, TArray<FProcMeshTangent>(), false);
+	PieceMeshComponent->SetMaterial(0, PieceMeshMaterial);
+
+	bIsPieceMeshDirty = false;
+	GenerationCursor = Layout->Cells.Num();
+}
+
+FColor AVRubiksCube::GetFaceColor(int32 Face) const
+{
+	const int32 PaletteIndex = FacePaletteIndices[Face];
+	return FaceColors.IsValidIndex(PaletteIndex) ? FaceColors[PaletteIndex].ToFColor(true) : FColor::Black;
+}
+
+void AVRubiksCube::AbortGeneration()
+{
+	bIsGenerating = false;
+	bIsIncomplete = true;
+	bIsInteractionEnabled = false;
+	UpdateTickEnabled();
+}
+
+void AVRubiksCube::FinishGeneration()
+{
+	bIsGenerating = false;
+	bIsIncomplete = false;
+	UpdateTickEnabled();
+
+	//The model may have been restored (journal, save game) while the pieces were being generated
+	SyncPiecesToModel();
+	OnCubeGenerationProgress.Broadcast(1.0f);
+	PlayIntroAnimation();
+
+	//Startup benchmark: first time the cube becomes interactive
+	if (StartupSeconds > 0.0) {
+		const double Now = FPlatformTime::Seconds();
+		UE_LOG(LogRubiks, Log, TEXT("%s: interactive %.1f ms after BeginPlay, %.2f s after process start"), *GetName(), (Now - StartupSeconds) * 1000.0, Now - GStartTime);
+		if (StartupBenchmarkRuns > 0) {
+			StartupInteractiveMs.Add((Now - StartupSeconds) * 1000.0);
+			StartupBenchmarkRuns--;
+
+			//Not from inside generation, the next run destroys the pieces it just finished
+			if (StartupBenchmarkRuns > 0) {
+				GetWorldTimerManager().SetTimerForNextTick(this, &AVRubiksCube::RestartStartup);
+			} else {
+				LogStartupBenchmark();
+			}
+		}
+		StartupSeconds = 0.0;
+	}
+}
+
+void AVRubiksCube::BenchmarkStartup(int32 Runs)
+{
+	//Only from a finished cube, a restart under streaming or generation would measure two startups at once
+	if (StartupBenchmarkRuns > 0 || Runs <= 0 || !bAreAssetsLoaded || bIsGenerating) {
+		return;
+	}
+	StartupBenchmarkRuns = Runs;
+	StartupAssetsMs.Reset();
+	StartupInteractiveMs.Reset();
+	RestartStartup();
+}
+
+void AVRubiksCube::RestartStartup()
+{
+	//Same state BeginPlay starts from: no pieces, no model, no journal, no hard references to the assets
+	CancelSolve();
+	StopTweens();
+	TransformCommitTick.SetTickFunctionEnable(false);
+	GetWorldTimerManager().ClearTimer(LodTimerHandle);
+	bIsSliceDirty = false;
+	bIsDragTurning = false;
+	bIsPlayingSolution = false;
+	bIsScrambling = false;
+	bIsAnimating = false;
+	DestroyPieces();
+	bIsGenerating = false;
+	bIsIncomplete = false;
+	bIsBuildPending = false;
+	Model = FVRubiksCubeModel();
+	Journal.Reset();
+	bAreAssetsLoaded = false;
+	LoadedPieceClass = nullptr;
+	LoadedFaceMaterials.Reset();
+	UpdateTickEnabled();
+
+	//Whatever nothing else holds on to is streamed in again
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+	StartupSeconds = FPlatformTime::Seconds();
+	RequestAssets();
+}
+
+void AVRubiksCube::LogStartupBenchmark()
+{
+	auto LogTimings = [this](const TCHAR* Name, const TArray<double>& Timings)
+	{
+		double Total = 0.0;
+		double Min = TNumericLimits<double>::Max();
+		double Max = 0.0;
+		for (double Milliseconds : Timings) {
+			Total += Milliseconds;
+			Min = FMath::Min(Min, Milliseconds);
+			Max = FMath::Max(Max, Milliseconds);
+		}
+		UE_LOG(LogRubiks, Display, TEXT("Startup benchmark %s: %s %d runs, %.1f ms average, %.1f ms min, %.1f ms max"),
+			*GetName(), Name, Timings.Num(), Total / FMath::Max(Timings.Num(), 1), Timings.Num() > 0 ? Min : 0.0, Max);
+	};
+	LogTimings(TEXT("assets ready"), StartupAssetsMs);
+	LogTimings(TEXT("interactive"), StartupInteractiveMs);
+}
+
+bool AVRubiksCube::AreAssetsLoaded()
+{
+	return bAreAssetsLoaded;
+}
+
+bool AVRubiksCube::IsGenerating()
+{
+	return bIsGenerating;
+}
+
+bool AVRubiksCube::IsIncomplete()
+{
+	return bIsIncomplete;
+}
+
+EVRubiksPieceLod AVRubiksCube::GetPieceLod()
+{
+	return TargetLod;
+}
+
+void AVRubiksCube::UpdateLod()
+{
+	APlayerCameraManager* CameraManager = UGameplayStatics::GetPlayerCameraManager(this, 0);
+	if (bIsGenerating || bIsIncomplete || !Layout || !CameraManager) {
+		return;
+	}
+
+	//Size of the closest pieces: the distance is taken to the near side of the cube
+	const float Scale = GetActorScale3D().GetMax();
+	const float PieceWidth = PieceSideWidth * Scale;
+	const FVector CubeCenter = GetActorTransform().TransformPosition(Layout->Center);
+	const float Distance = FMath::Max(FVector::Dist(CameraManager->GetCameraLocation(), CubeCenter) - PieceWidth * Size / 2, PieceWidth);
+	const float ScreenSize = FVRubiksLodPolicy::GetPieceScreenSize(PieceWidth, Distance, CameraManager->GetFOVAngle());
+
+	const EVRubiksPieceLod Lod = GetSupportedLod(LodPolicy.Select(ScreenSize, TargetLod));
+	if (Lod != TargetLod) {
+		BeginLodSwitch(Lod);
+	}
+}
+
+EVRubiksPieceLod AVRubiksCube::GetSupportedLod(EVRubiksPieceLod Lod) const
+{
+	if (Lod == EVRubiksPieceLod::Faces && !FaceLodMaterial) {
+		Lod = EVRubiksPieceLod::Stickers;
+	}
+
+	//The dynamic mesh pieces are already flat boxes
+	if (Lod == EVRubiksPieceLod::Stickers && (!StickerLodMesh || ActiveBackend == EVRubiksPieceBackend::DynamicMesh)) {
+		Lod = EVRubiksPieceLod::Full;
+	}
+	return Lod;
+}
+
+void AVRubiksCube::BeginLodSwitch(EVRubiksPieceLod Lod)
+{
+	UE_LOG(LogRubiks, Verbose, TEXT("%s: piece LOD %d -> %d"), *GetName(), (int32)TargetLod, (int32)Lod);
+	TargetLod = Lod;
+	LodSwitchCursor = 0;
+
+	//The face quads come up before the pieces go away, and go away only once every piece is back
+	if (Lod == EVRubiksPieceLod::Faces) {
+		BuildFaceLod();
+		FaceLodComponent->SetVisibility(true);
+	}
+
+	UStaticMesh* Mesh = Lod == EVRubiksPieceLod::Stickers ? StickerLodMesh : GetDefault<AVRubiksPiece>(LoadedPieceClass)->GetStaticMesh();
+	if (ActiveBackend == EVRubiksPieceBackend::Instanced) {
+		//A handful of components whatever the cube size, switched in one go
+		for (UInstancedStaticMeshComponent* Component : PieceInstanceComponents) {
+			if (Lod != EVRubiksPieceLod::Faces) {
+				Component->SetStaticMesh(Mesh);
+			}
+			Component->SetVisibility(Lod != EVRubiksPieceLod::Faces);
+		}
+		FinishLodSwitch();
+	} else if (ActiveBackend == EVRubiksPieceBackend::DynamicMesh) {
+		PieceMeshComponent->SetVisibility(Lod != EVRubiksPieceLod::Faces);
+		FinishLodSwitch();
+	} else {
+		UpdateTickEnabled();
+		SwitchNextPieces();
+	}
+}
+
+void AVRubiksCube::SwitchNextPieces()
+{
+	const int32 End = FMath::Min(LodSwitchCursor + FMath::Max(LodSwitchBatchSize, 1), Pieces.Num());
+	for (; LodSwitchCursor < End; LodSwitchCursor++) {
+		SetPieceActorLod(Pieces[LodSwitchCursor], TargetLod);
+	}
+
+	if (LodSwitchCursor >= Pieces.Num()) {
+		FinishLodSwitch();
+	}
+}
+
+void AVRubiksCube::FinishLodSwitch()
+{
+	CurrentLod = TargetLod;
+	LodSwitchCursor = 0;
+	if (CurrentLod != EVRubiksPieceLod::Faces && FaceLodComponent) {
+		FaceLodComponent->SetVisibility(false);
+	}
+	UpdateTickEnabled();
+}
+
+void AVRubiksCube::SetPieceActorLod(AVRubiksPiece* Piece, EVRubiksPieceLod Lod)
+{
+	//Hidden pieces keep their mesh, picking never looks at the pieces anyway
+	if (Lod != EVRubiksPieceLod::Faces) {
+		Piece->GetMeshComponent()->SetStaticMesh(Lod == EVRubiksPieceLod::Stickers ? StickerLodMesh : GetDefault<AVRubiksPiece>(LoadedPieceClass)->GetStaticMesh());
+	}
+	Piece->SetActorHiddenInGame(Lod == EVRubiksPieceLod::Faces);
+}
+
+void AVRubiksCube::ResetLod()
+{
+	if (CurrentLod == EVRubiksPieceLod::Full && TargetLod == EVRubiksPieceLod::Full) {
+		return;
+	}
+
+	for (AVRubiksPiece* Piece : Pieces) {
+		SetPieceActorLod(Piece, EVRubiksPieceLod::Full);
+	}
+	for (UInstancedStaticMeshComponent* Component : PieceInstanceComponents) {
+		Component->SetVisibility(true);
+	}
+	if (PieceMeshComponent) {
+		PieceMeshComponent->SetVisibility(true);
+	}
+
+	//GetInstanceComponent puts the piece mesh back on the instance components
+	TargetLod = EVRubiksPieceLod::Full;
+	FinishLodSwitch();
+}
+
+bool AVRubiksCube::IsFaceLodActive() const
+{
+	return CurrentLod == EVRubiksPieceLod::Faces || TargetLod == EVRubiksPieceLod::Faces;
+}
+
+void AVRubiksCube::BuildFaceLod()
+{
+	if (!FaceLodComponent) {
+		FaceLodComponent = NewObject<UProceduralMeshComponent>(this, FName("Face LOD"));
+		FaceLodComponent->SetupAttachment(GetRootComponent());
+		FaceLodComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		FaceLodComponent->SetVisibility(false);
+		FaceLodComponent->RegisterComponent();
+		FaceLodTextures.SetNumZeroed(6);
+		FaceLodMaterialInstances.SetNumZeroed(6);
+	}
+
+	if (FaceLodSize != Size) {
+		FaceLodSize = Size;
+
+		//Just off the piece faces, so the quads cover the pieces while they are hidden batch by batch
+		const float HalfWidth = PieceSideWidth * Size / 2;
+		const float Lift = PieceSideWidth * 0.01f;
+		for (int32 Face = 0; Face < 6; Face++) {
+			int32 ColAxis, RowAxis;
+			FVRubiksFaceletModel::GetFaceAxes(Face, ColAxis, RowAxis);
+			const int32 FaceAxis = FVRubiksFaceletModel::GetFaceAxis(Face);
+			const bool bPositive = FVRubiksFaceletModel::IsFacePositive(Face);
+
+			FVector Normal(0);
+			Normal[FaceAxis] = bPositive ? 1 : -1;
+			static const FVector2D CornerUVs[4] = { FVector2D(0, 0), FVector2D(1, 0), FVector2D(1, 1), FVector2D(0, 1) };
+			TArray<FVector> Vertices;
+			TArray<FVector> Normals;
+			TArray<FVector2D> UVs;
+			for (int32 Corner = 0; Corner < 4; Corner++) {
+				FVector Vertex = Layout->Center;
+				Vertex[FaceAxis] += bPositive ? HalfWidth + Lift : -HalfWidth - Lift;
+				Vertex[ColAxis] += (CornerUVs[Corner].X * 2 - 1) * HalfWidth;
+				Vertex[RowAxis] += (CornerUVs[Corner].Y * 2 - 1) * HalfWidth;
+				Vertices.Add(Vertex);
+				Normals.Add(Normal);
+				UVs.Add(CornerUVs[Corner]);
+			}
+
+			//Front faces wind clockwise in Unreal, which side that is depends on the face
+			const bool bFlip = (((Vertices[1] - Vertices[0]) ^ (Vertices[2] - Vertices[0])) | Normal) > 0;
+			const TArray<int32> Triangles = { 0, bFlip ? 2 : 1, bFlip ? 1 : 2, 0, bFlip ? 3 : 2, bFlip ? 2 : 3 };
+			FaceLodComponent->CreateMeshSection(Face, Vertices, Triangles, Normals, UVs, TArray<FColor>(), TArray<FProcMeshTangent>(), false);
+
+			UTexture2D*& Texture = FaceLodTextures[Face];
+			Texture = FVRubiksFaceTexture::Create(Size);
+
+			UMaterialInstanceDynamic*& MaterialInstance = FaceLodMaterialInstances[Face];
+			if (!MaterialInstance || MaterialInstance->Parent != FaceLodMaterial) {
+				MaterialInstance = UMaterialInstanceDynamic::Create(FaceLodMaterial, this);
+			}
+			MaterialInstance->SetTextureParameterValue(FName("Stickers"), Texture);
+			FaceLodComponent->SetMaterial(Face, MaterialInstance);
+		}
+	}
+
+	FaceLodTexels.SetNumUninitialized(6 * Size * Size);
+	for (int32 x = 0; x < Model.NumPieces(); x++) {
+		WriteFaceLodPiece(x);
+	}
+	UploadFaceLodTexels();
+}
+
+void AVRubiksCube::WriteFaceLodPiece(int32 PieceIndex)
+{
+	const FVRubiksCubeModel::FPiece& Piece = Model.GetPiece(PieceIndex);
+	const uint8 FaceMask = FVRubiksCubeLayout::GetFaceMask(Piece.Cell, Size);
+	const FQuat InverseRotation = Model.GetPieceRotation(PieceIndex).Inverse();
+	for (int32 Face = 0; Face < 6; Face++) {
+		if (!(FaceMask & (1 << Face))) {
+			continue;
+		}
+
+		//The sticker showing on Face is the one the piece had on the face it points there from its home cell
+		FVector Normal(0);
+		Normal[FVRubiksFaceletModel::GetFaceAxis(Face)] = FVRubiksFaceletModel::IsFacePositive(Face) ? 1 : -1;
+		const FVector HomeNormal = InverseRotation.RotateVector(Normal);
+		const int32 HomeAxis = FMath::Abs(HomeNormal.X) > 0.5f ? 0 : (FMath::Abs(HomeNormal.Y) > 0.5f ? 1 : 2);
+		const int32 HomeFace = FVRubiksFaceletModel::GetFace(HomeAxis, HomeNormal[HomeAxis] > 0);
+
+		int32 ColAxis, RowAxis;
+		FVRubiksFaceletModel::GetFaceAxes(Face, ColAxis, RowAxis);
+		const FIntPoint Texel(Piece.Cell[ColAxis], Piece.Cell[RowAxis]);
+		FaceLodTexels[(Face * Size + Texel.Y) * Size + Texel.X] = GetFaceColor(HomeFace);
+
+		FIntRect& DirtyRect = FaceLodDirtyRects[Face];
+		if (DirtyRect.Area() <= 0) {
+			DirtyRect = FIntRect(Texel, Texel + 1);
+		} else {
+			DirtyRect.Union(FIntRect(Texel, Texel + 1));
+		}
+	}
+}
+
+void AVRubiksCube::UploadFaceLodTexels()
+{
+	for (int32 Face = 0; Face < 6; Face++) {
+		const FIntRect Rect = FaceLodDirtyRects[Face];
+		FaceLodDirtyRects[Face] = FIntRect();
+		FVRubiksFaceTexture::UploadRect(FaceLodTextures[Face], Rect, [this, Face](int32 X, int32 Y)
+		{
+			return FaceLodTexels[(Face * Size + Y) * Size + X];
+		});
+	}
 }
 
-void AVRubiksCube::Build()
+void AVRubiksCube::Scramble()
 {
-	//Clear any tweening animations
-	FCTween::ClearActiveTweens();
-	SetActorScale3D(FVector::OneVector);
-	bIsScrambling = false;
-	bIsAnimating = false;
+	//Choose a random group based on a axis
+	EPieceGroup RotationGroupAxis = (EPieceGroup)FMath::RandRange(0, 2);
 
-	//Recreate the cube
-	OnCubeChanged.Broadcast(0);
-	DestroyPieces();
-	GeneratePieces();
+	//Choose a random layer for the group
+	int32 Layer = FMath::RandRange(0, Size - 1);
 
-	//Add a little scaling animation
-	FCTween::Play(
-	1.05f,
-	1.0f,
-	[&](float t)
-	{
-		SetActorScale3D(FVector::OneVector * t);
-	},
-	0.3f,
-	EFCEase::OutBack);
+	//Choose a random direction
+	int32 Random = FMath::RandRange(0, 1);
+	
+	//Scramble!
+	RotateMove(FVRubiksMove(RotationGroupAxis, Layer, Random ? -1 : 1), .25f);
 }
 
-// Called when the game starts or when spawned
-void AVRubiksCube::BeginPlay()
+bool AVRubiksCube::UsesStickerCustomData() const
 {
-	Super::BeginPlay();
-	Build();
+	return StickerMaterial != nullptr;
 }
 
-void AVRubiksCube::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
+UMaterialInstanceDynamic* AVRubiksCube::GetStickerMaterialInstance()
 {
-	Super::SetupPlayerInputComponent(PlayerInputComponent);
-	
-	APlayerController* PC = Cast<APlayerController>(GetController());
-	if (UEnhancedInputLocalPlayerSubsystem* Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(PC->GetLocalPlayer()))
-	{
-		Subsystem->ClearAllMappings();
-		Subsystem->AddMappingContext(DefaultMappingContext, 0);
-	}
-	
-	if (UEnhancedInputComponent* PlayerEnhancedInputComponent = Cast<UEnhancedInputComponent>(PlayerInputComponent))
-	{
-		if (InteractAction)
-		{
-			PlayerEnhancedInputComponent->BindAction(InteractAction, ETriggerEvent::Triggered, this, &AVRubiksCube::Input_Interact);
-			PlayerEnhancedInputComponent->BindAction(InteractAction, ETriggerEvent::Completed, this, &AVRubiksCube::Input_EndInteract);
+	//One instance of the sticker material for the whole cube, holding the palette
+	if (!StickerMaterialInstance || StickerMaterialInstance->Parent != StickerMaterial) {
+		StickerMaterialInstance = UMaterialInstanceDynamic::Create(StickerMaterial, this);
+		for (int32 x = 0; x < FMath::Min(FaceColors.Num(), 6); x++) {
+			StickerMaterialInstance->SetVectorParameterValue(UVRubiksColorSchemeLibrary::GetPaletteParameterName(x), FaceColors[x]);
 		}
 	}
+	return StickerMaterialInstance;
 }
 
-void AVRubiksCube::DestroyPieces()
+float AVRubiksCube::GetStickerValue(uint8 FaceMask, int32 Face) const
 {
-	PiecesToRotate.Empty();
-	for (int32 x = 0; x < Pieces.Num(); x++) {
-		Pieces[x]->Destroy();
-	}
-
-	Pieces.Empty();
-	RotatorSceneComponent->SetRelativeRotation(FRotator(0, 0, 0));
+	return (FaceMask & (1 << Face)) ? (float)FacePaletteIndices[Face] : (float)STICKER_NONE;
 }
 
-void AVRubiksCube::GeneratePieces()
+void AVRubiksCube::WritePieceStickerData(int32 PieceIndex)
 {
-	//Set new cube size
-	Steps = 0;
-	UWorld * World = GetWorld();
-	
-	//Create cube based on its size
-	for (int32 i = 0; i < Size; i++) {
-		for (int32 j = 0; j < Size; j++) {
-			for (int32 k = 0; k < Size; k++) {
-				//Spawn only pieces that belongs to a wall
-				if (World && (i == 0 || i == Size-1 || j == 0 || j == Size-1 || k ==0 || k == Size-1)) { 
-					//Spawn a rubiks piece
-					FActorSpawnParameters Params;
-					Params.Owner = this;
-					AVRubiksPiece * NewPiece = World->SpawnActor<AVRubiksPiece>(PieceClass, FVector::ZeroVector, FRotator(0.0f, 0.0f, 0.0f), Params);
-					NewPiece->SetActorLocation(FVector(NewPiece->GetSideWidth() * j, NewPiece->GetSideWidth() * i, NewPiece->GetSideWidth() * k));
-					NewPiece->AttachToActor(this, FAttachmentTransformRules::KeepWorldTransform, NAME_None);
-					NewPiece->Tags.Add(PIECE_TAG);
-					
-					UpdatePieceMaterials(NewPiece, j, i, k);
-					Pieces.Add(NewPiece);
-				}
+	//Stickers follow the home cell, the piece's rotation carries them around
+	const uint8 FaceMask = Layout->FaceMasks[PieceIndex];
+	if (ActiveBackend == EVRubiksPieceBackend::DynamicMesh) {
+		for (int32 Face = 0; Face < 6; Face++) {
+			if (FaceMask & (1 << Face)) {
+				PieceMesh.SetFaceColor(PieceIndex, Face, GetFaceColor(Face));
 			}
 		}
+		bIsPieceMeshDirty = true;
+	} else if (ActiveBackend == EVRubiksPieceBackend::Instanced) {
+		const FVRubiksPieceInstance& PieceInstance = PieceInstances[PieceIndex];
+		for (int32 Face = 0; Face < 6; Face++) {
+			PieceInstanceComponents[PieceInstance.Component]->SetCustomDataValue(PieceInstance.Instance, Face, GetStickerValue(FaceMask, Face), false);
+		}
+		DirtyInstanceComponents[PieceInstance.Component] = true;
+	} else {
+		for (int32 Face = 0; Face < 6; Face++) {
+			Pieces[PieceIndex]->SetStickerData(Face, GetStickerValue(FaceMask, Face));
+		}
 	}
-
-	//Set PieceRotator and camera's arm to the center of the new cube
-	float CubePieceSideWidth = Pieces[0]->GetSideWidth();
-	float CubeSideWidth = CubePieceSideWidth * GetSize();
-	float CubeSideCenter = (CubeSideWidth / 2) - (CubePieceSideWidth / 2); //Offset it a little because the origin of the piece it's in the center of the mesh
-	FVector CubeCenter = FVector(CubeSideCenter);
-	
-	RotatorSceneComponent->SetRelativeLocation(CubeCenter);
-	SpringArmComponent->SetRelativeLocation(CubeCenter);
-	SpringArmComponent->SetRelativeRotation(FRotator(-30, 0, 0));
-	SpringArmComponent->AddWorldRotation(FRotator(0, -45, 0));
-	SpringArmComponent->TargetArmLength = CubeSideWidth * 2;
 }
 
-void AVRubiksCube::Scramble()
+void AVRubiksCube::SetFacePaletteIndex(int32 Face, int32 PaletteIndex)
 {
-	//Choose a random group based on a axis
-	int32 Random = FMath::RandRange(0, 2);
-	EPieceGroup RotationGroupAxis = EPieceGroup::X;
-	FRotator Angle = FRotator::ZeroRotator;
-	switch (Random)
-	{
-	case 0:
-		RotationGroupAxis = EPieceGroup::X;
-		Angle = FRotator(0, 0, 90);
-		break;
-	case 1:
-		RotationGroupAxis = EPieceGroup::Y;
-		Angle = FRotator(90, 0, 0);
-		break;
-	case 2:
-		RotationGroupAxis = EPieceGroup::Z;
-		Angle = FRotator(0, 90, 0);
-		break;
-	default:
-		break;
+	if (Face < 0 || Face >= 6 || PaletteIndex < 0 || PaletteIndex >= STICKER_NONE) {
+		return;
 	}
+	FacePaletteIndices[Face] = PaletteIndex;
 
-	//Choose a random piece for the group
-	Random = FMath::RandRange(0, Pieces.Num() - 1);
-	AVRubiksPiece * RandomPiece = Pieces[Random];
+	if (IsFaceLodActive()) {
+		BuildFaceLod();
+	}
 
-	//Choose a random direction
-	Random = FMath::RandRange(0, 1);
-	if (Random) {
-		Angle *= -1;
+	//A recolor is only a custom data write on the pieces showing that face
+	if ((!UsesStickerCustomData() && ActiveBackend != EVRubiksPieceBackend::DynamicMesh) || !Layout || bIsGenerating) {
+		return;
 	}
-	
-	//Scramble!
-	RotateGroup(RandomPiece, RotationGroupAxis, Angle, .25f);
+	const int32 NumPieces = GetNumGeneratedPieces();
+	for (int32 x = 0; x < NumPieces; x++) {
+		if (Layout->FaceMasks[x] & (1 << Face)) {
+			WritePieceStickerData(x);
+		}
+	}
+	FlushPieceTransforms();
 }
 
-void AVRubiksCube::UpdatePieceMaterials(AVRubiksPiece* Piece, int32 X, int32 Y, int32 Z)
+void AVRubiksCube::SetColorScheme(const TArray<FLinearColor>& Colors)
 {
-	if (X == 0){ //Front
-		Piece->SetFaceMaterial(0, FaceMaterials[0]);
-	}
-	if (X == (Size-1)) { //Back
-		Piece->SetFaceMaterial(1, FaceMaterials[1]);
+	FaceColors = Colors;
+
+	//Shared palette and sticker material: six parameter writes, the pieces are not touched
+	UVRubiksColorSchemeLibrary::ApplyToPalette(this, PaletteCollection, FaceColors);
+	if (StickerMaterialInstance) {
+		for (int32 x = 0; x < FMath::Min(FaceColors.Num(), 6); x++) {
+			StickerMaterialInstance->SetVectorParameterValue(UVRubiksColorSchemeLibrary::GetPaletteParameterName(x), FaceColors[x]);
+		}
 	}
-	
-	if (Y == 0) { //Left
-		Piece->SetFaceMaterial(2, FaceMaterials[2]);
+
+	if (IsFaceLodActive()) {
+		BuildFaceLod();
 	}
-	if (Y == (Size-1)) { //Right
-		Piece->SetFaceMaterial(3, FaceMaterials[3]);
+
+	//The dynamic mesh bakes its colors in the vertices
+	if (ActiveBackend == EVRubiksPieceBackend::DynamicMesh && Layout && !bIsGenerating) {
+		for (int32 x = 0; x < PieceMesh.NumPieces(); x++) {
+			WritePieceStickerData(x);
+		}
+		FlushPieceTransforms();
 	}
+}
+
+void AVRubiksCube::SetColorSchemePreset(EVRubiksColorScheme Scheme)
+{
+	SetColorScheme(UVRubiksColorSchemeLibrary::GetSchemeColors(Scheme));
+}
 
-	if (Z == (Size-1)) { //Up
-		Piece->SetFaceMaterial(4, FaceMaterials[4]);
+void AVRubiksCube::UpdatePieceMaterials(AVRubiksPiece* Piece, uint8 FaceMask)
+{
+	if (UsesStickerCustomData()) {
+		//Same material on every piece, only the custom data differs
+		for (int32 Face = 0; Face < 6; Face++) {
+			Piece->SetFaceMaterial(Face, GetStickerMaterialInstance());
+			Piece->SetStickerData(Face, GetStickerValue(FaceMask, Face));
+		}
+		return;
 	}
-	if (Z == 0) { //Down
-		Piece->SetFaceMaterial(5, FaceMaterials[5]);
+
+	//Face bits follow the material slots: Front, Back, Left, Right, Up, Down
+	for (int32 Face = 0; Face < 6; Face++) {
+		if (FaceMask & (1 << Face)) {
+			Piece->SetFaceMaterial(Face, LoadedFaceMaterials[Face]);
+		}
 	}
 }
 
 void AVRubiksCube::Scramble(int32 TotalSteps)
 {
-	//Not scramble if it is already scrambling
-	if (bIsScrambling || bIsAnimating) {
+	//Not scramble if it is already scrambling, a pending build would wipe the scramble on the next tick
+	if (bIsScrambling || bIsAnimating || bIsGenerating || bIsIncomplete || bIsBuildPending || !bAreAssetsLoaded || IsSolving()) {
 		return;
 	}
 
@@ -230,6 +1451,12 @@ void AVRubiksCube::Scramble(int32 TotalSteps)
 	ScrambleCounter = TotalSteps;
 	bIsScrambling = true;
 	Steps = 0;
+	ResetTimer();
+
+	//The step reset starts a new snapshot, the scramble moves are journaled after it without counting as steps
+	if (Journal) {
+		Journal->Compact(Model, Steps);
+	}
 	OnCubeChanged.Broadcast(Steps);
 	Scramble();
 }
@@ -239,185 +1466,517 @@ int32 AVRubiksCube::GetSteps()
 	return Steps;
 }
 
+void AVRubiksCube::ResetTimer(float ElapsedTime)
+{
+	TimerStartSeconds = GetWorld() ? GetWorld()->GetTimeSeconds() - ElapsedTime : 0.0f;
+}
+
+float AVRubiksCube::GetElapsedTime()
+{
+	return GetWorld() ? GetWorld()->GetTimeSeconds() - TimerStartSeconds : 0.0f;
+}
+
+void AVRubiksCube::SaveCube(const FString& SlotName, int32 UserIndex)
+{
+	UVRubiksSaveGame* SaveGame = Cast<UVRubiksSaveGame>(UGameplayStatics::CreateSaveGameObject(UVRubiksSaveGame::StaticClass()));
+	SaveGame->Store(Model, Steps, GetElapsedTime(), History);
+
+	UGameplayStatics::AsyncSaveGameToSlot(SaveGame, SlotName, UserIndex, FAsyncSaveGameToSlotDelegate::CreateWeakLambda(this, [this](const FString&, const int32, bool bSuccess)
+	{
+		OnCubeSaved.Broadcast(bSuccess);
+	}));
+}
+
+void AVRubiksCube::LoadCube(const FString& SlotName, int32 UserIndex)
+{
+	UGameplayStatics::AsyncLoadGameFromSlot(SlotName, UserIndex, FAsyncLoadGameFromSlotDelegate::CreateWeakLambda(this, [this](const FString&, const int32, USaveGame* LoadedGame)
+	{
+		FVRubiksCubeModel LoadedModel;
+		int32 LoadedSteps = 0;
+		float LoadedElapsedTime = 0.0f;
+		TArray<FVRubiksMove> LoadedHistory;
+
+		//Never swap the model under a running animation
+		UVRubiksSaveGame* SaveGame = Cast<UVRubiksSaveGame>(LoadedGame);
+		if (!SaveGame || bIsAnimating || bIsScrambling || bIsIncomplete || !bAreAssetsLoaded || IsSolving()
+			|| !SaveGame->Restore(LoadedModel, LoadedSteps, LoadedElapsedTime, LoadedHistory)
+			|| LoadedModel.GetSize() < 2 || LoadedModel.GetSize() > 16) {
+			OnCubeLoaded.Broadcast(false);
+			return;
+		}
+
+		//One pass: replace the model and move every piece straight to its saved transform
+		RestoreModel(LoadedModel, LoadedSteps);
+		History = MoveTemp(LoadedHistory);
+		ResetTimer(LoadedElapsedTime);
+		OnCubeLoaded.Broadcast(true);
+	}));
+}
+
 bool AVRubiksCube::IsCubeSolved()
 {
-	AVRubiksPiece* Piece = Pieces[0];
-	FVector ForwardVector = Piece->GetActorForwardVector();
-	FVector UpVector = Piece->GetActorUpVector();
-	FVector RightVector = Piece->GetActorRightVector();
-	bool bIsSolved = true;
-	for (int32 x = 1; x < Pieces.Num(); x++) {
-		AVRubiksPiece* PieceToCompare = Pieces[x];
-		if (!ForwardVector.Equals(PieceToCompare->GetActorForwardVector(), 0.01f)
-			|| !UpVector.Equals(PieceToCompare->GetActorUpVector(), 0.01f)
-			|| !RightVector.Equals(PieceToCompare->GetActorRightVector(), 0.01f)) {
-				bIsSolved = false;
-			break;
+	//Every face showing one color, however the cube as a whole is turned
+	return Model.IsSolved();
+}
+
+int32 AVRubiksCube::GetMovesToSolve()
+{
+	//A query walks the table down to solved, a few microseconds, but must not wait for the table to be built
+	if (Model.GetSize() != 2 || !FVRubiks2x2Solver::IsTableReady()) {
+		return INDEX_NONE;
+	}
+	return FVRubiks2x2Solver::GetDistance(Model);
+}
+
+void AVRubiksCube::SolveCube(bool bAnimate)
+{
+	if (IsSolving() || bIsScrambling || bIsAnimating || bIsDragTurning || bIsGenerating || bIsIncomplete || bIsBuildPending || !bAreAssetsLoaded) {
+		return;
+	}
+	if (Model.IsSolved()) {
+		OnCubeSolveFinished.Broadcast(true, 0);
+		return;
+	}
+
+	//The worker gets its own copy of the model, the player cannot turn the cube until the solve is over
+	bAnimateSolution = bAnimate;
+	SolutionMoves.Empty();
+	SolutionCursor = 0;
+	SolveJob = MakeShared<FVRubiksSolveJob, ESPMode::ThreadSafe>();
+	UE::Tasks::Launch(UE_SOURCE_LOCATION, [Job = SolveJob, SolveModel = Model, TimeBudget = SolveTimeBudget]()
+	{
+		const bool bFoundSolution = VRubiksCube::FindSolution(SolveModel, TimeBudget, Job->bCancel, [&Job](const TArray<FVRubiksMove>& Moves)
+		{
+			FScopeLock Lock(&Job->Lock);
+			Job->Moves.Append(Moves);
+		});
+
+		FScopeLock Lock(&Job->Lock);
+		Job->bFoundSolution = bFoundSolution;
+		Job->bDone = true;
+	});
+	UpdateTickEnabled();
+}
+
+void AVRubiksCube::CancelSolve()
+{
+	//Moves of the stages already found stay applied, the count tells how many were applied or started turning
+	if (SolveJob) {
+		SolveJob->bCancel = true;
+		SolveJob.Reset();
+		UpdateTickEnabled();
+		OnCubeSolveFinished.Broadcast(false, SolutionCursor);
+	}
+
+	//The move already turning finishes, then playback stops. Playback waiting for the next stage stops right away
+	SolutionMoves.Empty();
+	SolutionCursor = 0;
+	if (bIsWaitingForSolution) {
+		bIsWaitingForSolution = false;
+		PlayNextSolutionMove();
+	}
+}
+
+bool AVRubiksCube::IsSolving()
+{
+	return SolveJob.IsValid() || bIsPlayingSolution;
+}
+
+void AVRubiksCube::PollSolve()
+{
+	TArray<FVRubiksMove> Moves;
+	bool bDone = false;
+	bool bFoundSolution = false;
+	{
+		FScopeLock Lock(&SolveJob->Lock);
+		Moves = MoveTemp(SolveJob->Moves);
+		bDone = SolveJob->bDone;
+		bFoundSolution = SolveJob->bFoundSolution;
+	}
+
+	//Bigger cubes report their solution stage by stage, each part is played or applied as soon as it arrives
+	if (Moves.Num() > 0) {
+		SolutionMoves.Append(Moves);
+		if (bAnimateSolution) {
+			if (!bIsPlayingSolution) {
+				bIsPlayingSolution = true;
+				bIsAnimating = true;
+				bIsInteractionEnabled = false;
+				PlayNextSolutionMove();
+			} else if (bIsWaitingForSolution) {
+				bIsWaitingForSolution = false;
+				PlayNextSolutionMove();
+			}
+		} else {
+			//Applied at once, each move still snaps only its own slice
+			for (const FVRubiksMove& Move : Moves) {
+				Model.GetSlicePieces(Move, PiecesToRotate);
+				CommitMove(Move, false);
+			}
+			SolutionCursor = SolutionMoves.Num();
+			OnCubeChanged.Broadcast(GetSteps());
 		}
 	}
-	
-	return bIsSolved;
+	if (!bDone) {
+		return;
+	}
+
+	SolveJob.Reset();
+	UpdateTickEnabled();
+	OnCubeSolveFinished.Broadcast(bFoundSolution, SolutionMoves.Num());
+
+	if (bIsWaitingForSolution) {
+		bIsWaitingForSolution = false;
+		PlayNextSolutionMove();
+	} else if (!bIsPlayingSolution) {
+		const bool bAppliedMoves = SolutionMoves.Num() > 0;
+		SolutionMoves.Empty();
+		SolutionCursor = 0;
+		if (bAppliedMoves && IsCubeSolved()) {
+			OnCubeSolved.Broadcast();
+		}
+	}
+}
+
+void AVRubiksCube::PlayNextSolutionMove()
+{
+	if (SolutionCursor < SolutionMoves.Num()) {
+		RotateMove(SolutionMoves[SolutionCursor++], SolutionMoveDuration);
+		return;
+	}
+
+	//Caught up with the search, PollSolve resumes once the next stage arrives
+	if (SolveJob) {
+		bIsWaitingForSolution = true;
+		return;
+	}
+
+	bIsPlayingSolution = false;
+	SolutionMoves.Empty();
+	SolutionCursor = 0;
+	bIsAnimating = false;
+	bIsInteractionEnabled = true;
+	OnCubeChanged.Broadcast(GetSteps());
+	if (IsCubeSolved()) {
+		OnCubeSolved.Broadcast();
+	}
 }
 
 void AVRubiksCube::Input_Interact(const FInputActionValue& InputActionValue)
 {
-	if (bIsScrambling) {
+	//Any number of samples in a frame cost one pick and gesture update, run from Tick
+	if (!bIsInteractPending) {
+		bIsInteractPending = true;
+		InteractInputSeconds = FPlatformTime::Seconds();
+		UpdateTickEnabled();
+	}
+}
+
+void AVRubiksCube::ProcessInteract()
+{
+	bIsInteractPending = false;
+	UpdateTickEnabled();
+	if (bIsScrambling || bIsGenerating || bIsIncomplete || IsSolving()) {
 		return;
 	}
 	
 	//Get player controller
 	APlayerController * PC = UGameplayStatics::GetPlayerController(GetWorld(), 0);
-	
-	if (bIsInteractionEnabled && !bIsAnimating){ //Start movement detection
-		FVector MouseWorldPosition;
-		FVector MouseWorldDirection;
-
-		//Project mouse position from screen to 3d world
-		PC->DeprojectMousePositionToWorld(MouseWorldPosition, MouseWorldDirection);
-
-		//Calculating the end of the ray
-		FVector TraceEnd = MouseWorldPosition + (MouseWorldDirection * 100000); //long ray
-
-		FHitResult HitResult;
-		FCollisionQueryParams TraceParams;
-		TraceParams.bTraceComplex = false;
-
-		//Trace a ray to find a Rubiks piece
-		if (GetWorld()->LineTraceSingleByChannel(HitResult, MouseWorldPosition, TraceEnd, ECC_Visibility, TraceParams) && !bIsCameraMoving) { // && !IsCubeSolved()
-			//Verifies if the object is a rubiks piece
-			if (HitResult.GetActor()->Tags.Contains(PIECE_TAG)) {
-				if (ClickedPiece == nullptr) {
-					ClickedPiece = Cast<AVRubiksPiece>(HitResult.GetActor());
-					ClickedWorldPosition = HitResult.ImpactPoint;
-					ClickedWorldNormal = HitResult.ImpactNormal;
-				} else { //Already dragging the mouse over a piece
-					FVector Direction = HitResult.ImpactPoint - ClickedWorldPosition;
-					int32 DragDistance = Direction.Size();
-					if (DragDistance > DRAG_DISTANCE) { //Detect movement
-						FVector NormalizedDirection = Direction.GetSafeNormal();
-						bIsInteractionEnabled = false;
-						//Start the rotation process
-						Steps++;
-						RotateFromPiece(ClickedPiece, ClickedWorldNormal, NormalizedDirection);
+
+	FVector MouseWorldPosition;
+	FVector MouseWorldDirection;
+
+	//Project mouse position from screen to 3d world
+	PC->DeprojectMousePositionToWorld(MouseWorldPosition, MouseWorldDirection);
+
+	//The slice follows the hand until the button is released
+	if (bIsDragTurning) {
+		FVector DragPosition;
+		if (GetDragPosition(MouseWorldPosition, MouseWorldDirection, DragPosition)) {
+			UpdateDragTurn(DragPosition);
+		}
+		return;
+	}
+
+	//A snapping slice does not block the next move, it lands right away
+	if (bIsInteractionEnabled && (!bIsAnimating || SnapTween)){ //Start movement detection
+		int32 HitPieceIndex = INDEX_NONE;
+		FVector HitPosition;
+		FVector HitNormal;
+		if (ClickedPieceIndex != INDEX_NONE) { //Already dragging the mouse over a piece
+			//Measured on the clicked face's plane, the drag may leave the cube
+			FVector DragPosition;
+			if (GetDragPosition(MouseWorldPosition, MouseWorldDirection, DragPosition)) {
+				FVector Direction = DragPosition - ClickedWorldPosition;
+				int32 DragDistance = Direction.Size();
+				if (DragDistance > DRAG_DISTANCE) { //Detect movement
+					bIsInteractionEnabled = false;
+					//Start the rotation process
+					BeginDragTurn(Direction.GetSafeNormal());
+					if (bIsDragTurning) {
+						UpdateDragTurn(DragPosition);
 					}
 				}
-			}			
-        } else if (ClickedPiece == nullptr){ //Camera movement
-            bIsCameraMoving = true;
-			//Get mouse movement axis for camera rotation
-        	FVector CameraMovement;
-			PC->GetInputMouseDelta(CameraMovement.X, CameraMovement.Y);
-			//Rotate the camera
-        	SpringArmComponent->AddWorldRotation(FRotator(0, CameraMovement.X * 2, 0));
-        	SpringArmComponent->AddRelativeRotation(FRotator(CameraMovement.Y * 2, 0, 0));
-        	//Clamp Y rotation
-        	FRotator SpringArmRotation = SpringArmComponent->GetComponentRotation();
-        	SpringArmComponent->SetRelativeRotation(FRotator(FMath::Clamp(SpringArmRotation.Pitch, -CAMERA_Y_ANGLE_LIMIT, CAMERA_Y_ANGLE_LIMIT), SpringArmRotation.Yaw, SpringArmRotation.Roll));
-        }
+			}
+		} else {
+			//The model must be current to pick, a new press lands the snapping slice first
+			if (!bIsCameraMoving) {
+				FinishSnap();
+			}
+
+			//Intersect the ray with the cube itself, no physics involved
+			if (!bIsCameraMoving && PickPiece(MouseWorldPosition, MouseWorldDirection, HitPieceIndex, HitPosition, HitNormal)) { // && !IsCubeSolved()
+				ClickedPieceIndex = HitPieceIndex;
+				ClickedWorldPosition = HitPosition;
+				ClickedWorldNormal = HitNormal;
+			} else { //Camera movement
+				bIsCameraMoving = true;
+				//Get mouse movement axis for camera rotation
+				FVector CameraMovement;
+				PC->GetInputMouseDelta(CameraMovement.X, CameraMovement.Y);
+				//Rotate the camera
+				SpringArmComponent->AddWorldRotation(FRotator(0, CameraMovement.X * 2, 0));
+				SpringArmComponent->AddRelativeRotation(FRotator(CameraMovement.Y * 2, 0, 0));
+				//Clamp Y rotation
+				FRotator SpringArmRotation = SpringArmComponent->GetComponentRotation();
+				SpringArmComponent->SetRelativeRotation(FRotator(FMath::Clamp(SpringArmRotation.Pitch, -CAMERA_Y_ANGLE_LIMIT, CAMERA_Y_ANGLE_LIMIT), SpringArmRotation.Yaw, SpringArmRotation.Roll));
+			}
+		}
 	}
 }
 
 void AVRubiksCube::Input_EndInteract(const FInputActionValue& InputActionValue)
 {
+	//A drag released within the frame still counts
+	if (bIsInteractPending) {
+		ProcessInteract();
+	}
+
+	if (bIsDragTurning) {
+		EndDragTurn();
+	}
+
 	//Reset state
 	bIsInteractionEnabled = true;
 	bIsCameraMoving = false;
-	ClickedPiece = nullptr;
+	ClickedPieceIndex = INDEX_NONE;
 	ClickedWorldPosition = FVector::ZeroVector;
 	ClickedWorldNormal = FVector::ZeroVector;
 }
 
-void AVRubiksCube::RotateFromPiece(AVRubiksPiece * Piece, FVector Normal, FVector Direction)
+bool AVRubiksCube::GetDragPosition(const FVector& RayOrigin, const FVector& RayDirection, FVector& OutPosition) const
+{
+	const float Denominator = RayDirection | ClickedWorldNormal;
+	if (FMath::IsNearlyZero(Denominator)) {
+		return false;
+	}
+
+	const float Distance = ((ClickedWorldPosition - RayOrigin) | ClickedWorldNormal) / Denominator;
+	if (Distance <= 0.0f) {
+		return false;
+	}
+	OutPosition = RayOrigin + RayDirection * Distance;
+	return true;
+}
+
+void AVRubiksCube::BeginDragTurn(const FVector& Direction)
+{
+	FVRubiksMove Move;
+	if (!GetMoveFromDrag(ClickedPieceIndex, ClickedWorldNormal, Direction, Move)) {
+		return;
+	}
+
+	//Locked on the axis the drag was detected along, sideways motion is ignored from now on
+	const int32 DirectionAxis = FMath::Abs(Direction.X) > 0.9f ? 0 : (FMath::Abs(Direction.Y) > 0.9f ? 1 : 2);
+	DragDirection = FVector::ZeroVector;
+	DragDirection[DirectionAxis] = FMath::Sign(Direction[DirectionAxis]);
+	DragMove = Move;
+	DragAngle = 0.0f;
+	bIsDragTurning = true;
+	TurnInputSeconds = InteractInputSeconds;
+	BeginSliceTurn(Move);
+}
+
+void AVRubiksCube::UpdateDragTurn(const FVector& DragPosition)
+{
+	const float QuarterTurnLength = FMath::Max(DragPiecesPerQuarterTurn * PieceSideWidth * GetActorScale3D().X, KINDA_SMALL_NUMBER);
+	DragAngle = 90.0f * ((DragPosition - ClickedWorldPosition) | DragDirection) / QuarterTurnLength;
+
+	//Written to the pieces by the commit tick, like a tweened turn
+	SliceRotation = FVRubiksMove::GetAxisRotation(DragMove.Axis, DragAngle * DragMove.QuarterTurns);
+	bIsSliceDirty = true;
+}
+
+void AVRubiksCube::EndDragTurn()
+{
+	bIsDragTurning = false;
+
+	//Nearest quarter turn, a full turn or none lands back where it started
+	const int32 QuarterTurns = FMath::RoundToInt(DragAngle / 90.0f) * DragMove.QuarterTurns;
+	const int32 Normalized = ((QuarterTurns % 4) + 4) % 4;
+	SnapMove = FVRubiksMove(DragMove.Axis, DragMove.Layer, Normalized == 3 ? -1 : Normalized);
+
+	SnapTween = FCTween::Play(
+	SliceRotation,
+	FVRubiksMove::GetAxisRotation(DragMove.Axis, QuarterTurns * 90.0f),
+	[&](FQuat t)
+	{
+		SliceRotation = t;
+		bIsSliceDirty = true;
+	},
+	SnapDuration,
+	EFCEase::OutQuad)->SetOnComplete([this]() {
+		SnapTween = nullptr;
+		CompleteDragTurn();
+	});
+}
+
+void AVRubiksCube::FinishSnap()
+{
+	if (!SnapTween) {
+		return;
+	}
+
+	SnapTween->Destroy();
+	SnapTween = nullptr;
+	CompleteDragTurn();
+}
+
+void AVRubiksCube::CompleteDragTurn()
+{
+	if (SnapMove.QuarterTurns != 0) {
+		Steps++;
+		CommitMove(SnapMove, true);
+	} else {
+		//Cancelled: the slice goes back to the model, nothing to commit
+		bIsSliceDirty = false;
+		TransformCommitTick.SetTickFunctionEnable(false);
+		for (int32 x = 0; x < PiecesToRotate.Num(); x++) {
+			SnapPieceToModel(PiecesToRotate[x]);
+		}
+		FlushPieceTransforms();
+		PiecesToRotate.Empty();
+	}
+
+	bIsAnimating = false;
+	OnCubeChanged.Broadcast(GetSteps());
+	if (SnapMove.QuarterTurns != 0 && IsCubeSolved()) {
+		OnCubeSolved.Broadcast();
+	}
+}
+
+bool AVRubiksCube::GetMoveFromDrag(int32 PieceIndex, FVector Normal, FVector Direction, FVRubiksMove& OutMove) const
 { 
 	if (Normal.Equals(FVector::UpVector)) { //Top Face
 		if(FMath::Abs(Direction.X) > 0.9f) {
-			RotateGroup(Piece, EPieceGroup::Y, FRotator(FMath::Sign(Direction.X) * -90, 0, 0));
+			return GetGroupMove(PieceIndex, EPieceGroup::Y, FRotator(FMath::Sign(Direction.X) * -90, 0, 0), OutMove);
 		} else if (FMath::Abs(Direction.Y) > 0.9f) {
-			RotateGroup(Piece, EPieceGroup::X, FRotator(0, 0, FMath::Sign(Direction.Y) * 90));
+			return GetGroupMove(PieceIndex, EPieceGroup::X, FRotator(0, 0, FMath::Sign(Direction.Y) * 90), OutMove);
 		}
 	}
 	else if (Normal.Equals(FVector::DownVector)) { //Bottom Face
 		if(FMath::Abs(Direction.X) > 0.9f) {
-			RotateGroup(Piece, EPieceGroup::Y, FRotator(FMath::Sign(Direction.X) * 90, 0, 0));
+			return GetGroupMove(PieceIndex, EPieceGroup::Y, FRotator(FMath::Sign(Direction.X) * 90, 0, 0), OutMove);
 		} else if (FMath::Abs(Direction.Y) > 0.9f) {
-			RotateGroup(Piece, EPieceGroup::X, FRotator(0, 0, FMath::Sign(Direction.Y) * -90));
+			return GetGroupMove(PieceIndex, EPieceGroup::X, FRotator(0, 0, FMath::Sign(Direction.Y) * -90), OutMove);
 		}
 	}
 	else if (Normal.Equals(FVector::ForwardVector)) { //Back face
 		if(FMath::Abs(Direction.Z) > 0.9f) {
-			RotateGroup(Piece, EPieceGroup::Y, FRotator(FMath::Sign(Direction.Z) * 90, 0, 0));
+			return GetGroupMove(PieceIndex, EPieceGroup::Y, FRotator(FMath::Sign(Direction.Z) * 90, 0, 0), OutMove);
 		} else if (FMath::Abs(Direction.Y) > 0.9f) {
-			RotateGroup(Piece, EPieceGroup::Z, FRotator(0, FMath::Sign(Direction.Y) * 90, 0));
+			return GetGroupMove(PieceIndex, EPieceGroup::Z, FRotator(0, FMath::Sign(Direction.Y) * 90, 0), OutMove);
 		}
 	}
 	else if (Normal.Equals(FVector::BackwardVector)) { //Front Face
 		if(FMath::Abs(Direction.Z) > 0.9f) {
-			RotateGroup(Piece, EPieceGroup::Y, FRotator(FMath::Sign(Direction.Z) * -90, 0, 0));
+			return GetGroupMove(PieceIndex, EPieceGroup::Y, FRotator(FMath::Sign(Direction.Z) * -90, 0, 0), OutMove);
 		} else if (FMath::Abs(Direction.Y) > 0.9f) {
-			RotateGroup(Piece, EPieceGroup::Z, FRotator(0, FMath::Sign(Direction.Y) * -90, 0));
+			return GetGroupMove(PieceIndex, EPieceGroup::Z, FRotator(0, FMath::Sign(Direction.Y) * -90, 0), OutMove);
 		}
 	}
 	else if (Normal.Equals(FVector::LeftVector)) { //Left Face
 		if(FMath::Abs(Direction.Z) > 0.9f) {
-			RotateGroup(Piece, EPieceGroup::X, FRotator(0, 0, FMath::Sign(Direction.Z) * 90));
+			return GetGroupMove(PieceIndex, EPieceGroup::X, FRotator(0, 0, FMath::Sign(Direction.Z) * 90), OutMove);
 		} else if (FMath::Abs(Direction.X) > 0.9f) {
-			RotateGroup(Piece, EPieceGroup::Z, FRotator(0, FMath::Sign(Direction.X) * 90, 0));
+			return GetGroupMove(PieceIndex, EPieceGroup::Z, FRotator(0, FMath::Sign(Direction.X) * 90, 0), OutMove);
 		}
 	}
 	else if (Normal.Equals(FVector::RightVector)) { //Right Face
 		if(FMath::Abs(Direction.Z) > 0.9f) {
-			RotateGroup(Piece, EPieceGroup::X, FRotator(0, 0, FMath::Sign(Direction.Z) * -90));
+			return GetGroupMove(PieceIndex, EPieceGroup::X, FRotator(0, 0, FMath::Sign(Direction.Z) * -90), OutMove);
 		} else if (FMath::Abs(Direction.X) > 0.9f) {
-			RotateGroup(Piece, EPieceGroup::Z, FRotator(0, FMath::Sign(Direction.X) * -90, 0));
+			return GetGroupMove(PieceIndex, EPieceGroup::Z, FRotator(0, FMath::Sign(Direction.X) * -90, 0), OutMove);
 		}
 	}
-    
+	return false;
 }
 
-void AVRubiksCube::RotateGroup(AVRubiksPiece * Piece, EPieceGroup GroupAxis, FRotator Rotation, float Speed)
+bool AVRubiksCube::GetGroupMove(int32 PieceIndex, EPieceGroup GroupAxis, FRotator Rotation, FVRubiksMove& OutMove) const
 {
-	//Clean array of the pieces that will rotate
-	PiecesToRotate.Empty();
-
-	//Remove parent from all pieces
-	for (int32 x = 0; x < Pieces.Num(); x++) {
-		Pieces[x]->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+	//Translate the group rotation into a move on the slice the piece currently sits in
+	if (!Model.GetSize() || PieceIndex < 0 || PieceIndex >= Model.NumPieces()) {
+		return false;
 	}
 
-	//Reset rotation from PieceRotator
-	RotatorSceneComponent->SetRelativeRotation(FRotator(0, 0, 0));
-	//Add all pieces from the same group as the given piece to the PiecesToRotate array (used fabs just to prevent possible minimal erros)
-	for (int32 x = 0; x < Pieces.Num(); x++) {
-		if (GroupAxis == EPieceGroup::X && FMath::Abs(Pieces[x]->GetActorLocation().X - Piece->GetActorLocation().X) < 5.0f) {
-			PiecesToRotate.Add(Pieces[x]);
-		} else if (GroupAxis == EPieceGroup::Y && FMath::Abs(Pieces[x]->GetActorLocation().Y - Piece->GetActorLocation().Y) < 5.0f) {
-			PiecesToRotate.Add(Pieces[x]);
-		} else if (GroupAxis == EPieceGroup::Z && FMath::Abs(Pieces[x]->GetActorLocation().Z - Piece->GetActorLocation().Z) < 5.0f) {
-			PiecesToRotate.Add(Pieces[x]);
-		}
+	float Angle = GroupAxis == EPieceGroup::X ? Rotation.Roll : (GroupAxis == EPieceGroup::Y ? Rotation.Pitch : Rotation.Yaw);
+	int32 QuarterTurns = FMath::RoundToInt(Angle / 90.0f);
+	if (QuarterTurns == 0) {
+		return false;
 	}
 
-	//Set all the pieces to rotate as child of the PieceRotator
+	OutMove = FVRubiksMove(GroupAxis, Model.GetPiece(PieceIndex).Cell[GroupAxis], QuarterTurns);
+	return true;
+}
+
+void AVRubiksCube::BeginSliceTurn(const FVRubiksMove& Move)
+{
+	//Add all pieces from the move's slice to the PiecesToRotate array
+	Model.GetSlicePieces(Move, PiecesToRotate);
+
+	//No hierarchy for the slice: keep each piece's transform relative to the slice pivot and rotate them by hand
+	SliceStartTransforms.SetNumUninitialized(PiecesToRotate.Num());
 	for (int32 x = 0; x < PiecesToRotate.Num(); x++) {
-		PiecesToRotate[x]->AttachToComponent(RotatorSceneComponent, FAttachmentTransformRules::KeepWorldTransform, NAME_None);
+		SliceStartTransforms[x] = GetPieceModelTransform(PiecesToRotate[x]) * FTransform(-Layout->Center);
 	}
 
-	//Rotate PieceRotator
+	SliceRotation = FQuat::Identity;
+	bIsSliceDirty = false;
+	TransformCommitTick.SetTickFunctionEnable(true);
 	bIsAnimating = true;
-	ClickedPiece = nullptr;
+}
+
+void AVRubiksCube::RotateMove(const FVRubiksMove& Move, float Speed)
+{
+	//An incomplete cube has no pieces past the ones it generated to turn
+	if (bIsIncomplete) {
+		return;
+	}
+	BeginSliceTurn(Move);
+
+	//Rotate the slice
+	ClickedPieceIndex = INDEX_NONE;
 	ClickedWorldNormal = FVector::ZeroVector;
 	ClickedWorldPosition = FVector::ZeroVector;
 	
-	FCTween::Play(
+	TurnTween = FCTween::Play(
 	FRotator(0, 0, 0).Quaternion(),
-	Rotation.Quaternion(),
+	Move.GetRotation(),
 	[&](FQuat t)
 	{
-		RotatorSceneComponent->SetWorldRotation(t.Rotator());
+		//Only recorded here, the pieces move once per frame in CommitPieceTransforms
+		SliceRotation = t;
+		bIsSliceDirty = true;
 	},
 	Speed,
-	EFCEase::OutBack)->SetOnComplete([&]() {
-		if (!bIsScrambling) {
+	EFCEase::OutBack)->SetOnComplete([this, Move]() {
+		TurnTween = nullptr;
+		CommitMove(Move, !bIsScrambling && !bIsPlayingSolution);
+
+		if (bIsPlayingSolution) {
+			PlayNextSolutionMove();
+		}
+		else if (!bIsScrambling) {
 			bIsAnimating = false;
 			bIsInteractionEnabled = true;
 			OnCubeChanged.Broadcast(GetSteps());
@@ -439,4 +1998,34 @@ void AVRubiksCube::RotateGroup(AVRubiksPiece * Piece, EPieceGroup GroupAxis, FRo
 			}
 		}
 	});
-}
\ No newline at end of file
+}
+
+void AVRubiksCube::CommitMove(const FVRubiksMove& Move, bool bCountsAsStep)
+{
+	Model.ApplyMove(Move);
+	History.Add(Move);
+
+	//Snap the slice to its exact logical transform, so float errors never accumulate
+	bIsSliceDirty = false;
+	TransformCommitTick.SetTickFunctionEnable(false);
+	for (int32 x = 0; x < PiecesToRotate.Num(); x++) {
+		SnapPieceToModel(PiecesToRotate[x]);
+	}
+	FlushPieceTransforms();
+
+	//Only the stickers of the turned slice change on the face textures
+	if (IsFaceLodActive()) {
+		for (int32 x = 0; x < PiecesToRotate.Num(); x++) {
+			WriteFaceLodPiece(PiecesToRotate[x]);
+		}
+		UploadFaceLodTexels();
+	}
+	PiecesToRotate.Empty();
+
+	if (Journal) {
+		Journal->Append(Move, bCountsAsStep);
+		if (Journal->NeedsCompaction()) {
+			Journal->Compact(Model, Steps);
+		}
+	}
+}
@@ -0,0 +1,257 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VRubiksCubeCrowd.h"
+#include "VRubiksColorScheme.h"
+#include "RubiksCube.h"
+#include "FCTween.h"
+#include "VRubiksCube.h"
+#include "VRubiksCubeLayout.h"
+#include "VRubiksPiece.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+DECLARE_CYCLE_STAT(TEXT("Crowd Tick"), STAT_RubiksCrowdTick, STATGROUP_Rubiks);
+
+namespace VRubiksCubeCrowd
+{
+	static void RunBenchmark(const TArray<FString>& Args)
+	{
+		const int32 NumCubes = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000;
+		const int32 NumFrames = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 600;
+
+		FVRubiksCrowdSimulation Simulation;
+		Simulation.Reset(FMath::Max(NumCubes, 1), 40, 10.0f, 1.5f, 0);
+
+		//Same work as the actor: simulate, then copy the dirty range as the batch would
+		TArray<FTransform> Batch;
+		double TotalSeconds = 0.0;
+		double MaxSeconds = 0.0;
+		for (int32 Frame = 0; Frame < NumFrames; Frame++) {
+			const double StartTime = FPlatformTime::Seconds();
+			int32 FirstDirty, LastDirty;
+			Simulation.Tick(1.0f / 60.0f, FirstDirty, LastDirty);
+			if (FirstDirty <= LastDirty) {
+				Batch.Reset();
+				Batch.Append(Simulation.GetTransforms().GetData() + FirstDirty, LastDirty - FirstDirty + 1);
+			}
+			const double FrameSeconds = FPlatformTime::Seconds() - StartTime;
+			TotalSeconds += FrameSeconds;
+			MaxSeconds = FMath::Max(MaxSeconds, FrameSeconds);
+		}
+
+		UE_LOG(LogRubiks, Display, TEXT("Crowd benchmark: %d cubes, %d frames, %.3f ms average, %.3f ms max per frame"),
+			Simulation.NumCubes(), NumFrames, TotalSeconds * 1000.0 / FMath::Max(NumFrames, 1), MaxSeconds * 1000.0);
+	}
+
+	static FAutoConsoleCommand BenchmarkCommand(
+		TEXT("Rubiks.CrowdBenchmark"),
+		TEXT("Runs the cube crowd simulation without rendering and logs its cost per frame. Usage: Rubiks.CrowdBenchmark [Cubes=1000] [Frames=600]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&RunBenchmark));
+}
+
+FVRubiksCrowdMoveTable::FVRubiksCrowdMoveTable()
+{
+	TArray<FIntVector> Cells;
+	FVRubiksCubeModel::GetSurfaceCells(3, Cells);
+	check(Cells.Num() == NumPieces);
+	for (int32 Slot = 0; Slot < NumPieces; Slot++) {
+		SlotCells[Slot] = Cells[Slot];
+		SlotFaceMasks[Slot] = FVRubiksCubeLayout::GetFaceMask(Cells[Slot], 3);
+	}
+
+	//Apply each move once to a solved model, where piece N starts in slot N
+	static const int32 Turns[3] = { 1, -1, 2 };
+	FVRubiksCubeModel Model;
+	for (int32 Move = 0; Move < NumMoves; Move++) {
+		Moves[Move] = FVRubiksMove(Move / 9, (Move / 3) % 3, Turns[Move % 3]);
+		Moves[Move].GetRotation().ToAxisAndAngle(MoveAxes[Move], MoveAngles[Move]);
+
+		SliceSizes[Move] = 0;
+		for (int32 Slot = 0; Slot < NumPieces; Slot++) {
+			if (Cells[Slot][Moves[Move].Axis] == Moves[Move].Layer) {
+				SliceSlots[Move][SliceSizes[Move]++] = (uint8)Slot;
+			}
+		}
+
+		Model.Reset(3);
+		Model.ApplyMove(Moves[Move]);
+		for (int32 Slot = 0; Slot < NumPieces; Slot++) {
+			SlotAfter[Move][Slot] = (uint8)Cells.IndexOfByKey(Model.GetPiece(Slot).Cell);
+		}
+	}
+}
+
+const FVRubiksCrowdMoveTable& FVRubiksCrowdMoveTable::Get()
+{
+	static const FVRubiksCrowdMoveTable Table;
+	return Table;
+}
+
+FVRubiksCrowdSimulation::FVRubiksCrowdSimulation()
+	: MoveDuration(0.4f)
+	, MaxIdleTime(1.0f)
+	, PieceWidth(0.0f)
+{
+}
+
+void FVRubiksCrowdSimulation::Reset(int32 NumCubes, int32 Columns, float InPieceWidth, float Spacing, int32 Seed)
+{
+	PieceWidth = InPieceWidth;
+	Random.Initialize(Seed);
+
+	const float CubeStep = PieceWidth * 3 * Spacing;
+	Cubes.SetNumUninitialized(NumCubes);
+	Transforms.SetNumUninitialized(NumCubes * FVRubiksCrowdMoveTable::NumPieces);
+	for (int32 CubeIndex = 0; CubeIndex < NumCubes; CubeIndex++) {
+		FCube& Cube = Cubes[CubeIndex];
+		for (int32 Slot = 0; Slot < FVRubiksCrowdMoveTable::NumPieces; Slot++) {
+			Cube.SlotPieces[Slot] = (uint8)Slot;
+			Cube.Orientations[Slot] = 0;
+		}
+		Cube.Move = INDEX_NONE;
+		Cube.Time = -Random.FRandRange(0.0f, MaxIdleTime);
+		Cube.Origin = FVector((CubeIndex % Columns) * CubeStep, (CubeIndex / Columns) * CubeStep, 0.0f);
+
+		for (int32 Slot = 0; Slot < FVRubiksCrowdMoveTable::NumPieces; Slot++) {
+			SetPieceTransform(Cube, CubeIndex, Slot, FQuat::Identity);
+		}
+	}
+}
+
+void FVRubiksCrowdSimulation::SetPieceTransform(const FCube& Cube, int32 CubeIndex, int32 Slot, const FQuat& SliceRotation)
+{
+	//Turn around the cube center, which is the middle cell of a 3x3
+	const FVRubiksCrowdMoveTable& Table = FVRubiksCrowdMoveTable::Get();
+	const int32 Piece = Cube.SlotPieces[Slot];
+	const FVector Center(PieceWidth);
+	const FVector Offset = FVector(Table.SlotCells[Slot]) * PieceWidth - Center;
+	Transforms[CubeIndex * FVRubiksCrowdMoveTable::NumPieces + Piece] = FTransform(
+		SliceRotation * FVRubiksCubeModel::GetOrientationQuat(Cube.Orientations[Piece]),
+		Cube.Origin + Center + SliceRotation.RotateVector(Offset));
+}
+
+void FVRubiksCrowdSimulation::Tick(float DeltaSeconds, int32& OutFirstDirty, int32& OutLastDirty)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RubiksCrowdTick);
+
+	const FVRubiksCrowdMoveTable& Table = FVRubiksCrowdMoveTable::Get();
+	OutFirstDirty = MAX_int32;
+	OutLastDirty = INDEX_NONE;
+
+	//One pass and one easing per cube, instead of a tween per cube
+	for (int32 CubeIndex = 0; CubeIndex < Cubes.Num(); CubeIndex++) {
+		FCube& Cube = Cubes[CubeIndex];
+		Cube.Time += DeltaSeconds;
+		if (Cube.Move == INDEX_NONE) {
+			if (Cube.Time < 0.0f) {
+				continue;
+			}
+			Cube.Move = Random.RandRange(0, FVRubiksCrowdMoveTable::NumMoves - 1);
+			Cube.Time = 0.0f;
+		}
+
+		const int32 Move = Cube.Move;
+		const float Alpha = FMath::Min(Cube.Time / MoveDuration, 1.0f);
+		FQuat SliceRotation = FQuat::Identity;
+		if (Alpha >= 1.0f) {
+			//Commit: move the slice pieces to their new slots, then draw them unrotated there
+			uint8 SlicePieces[9];
+			for (int32 x = 0; x < Table.SliceSizes[Move]; x++) {
+				SlicePieces[x] = Cube.SlotPieces[Table.SliceSlots[Move][x]];
+			}
+			for (int32 x = 0; x < Table.SliceSizes[Move]; x++) {
+				const uint8 Piece = SlicePieces[x];
+				Cube.SlotPieces[Table.SlotAfter[Move][Table.SliceSlots[Move][x]]] = Piece;
+				Cube.Orientations[Piece] = FVRubiksCubeModel::TurnOrientation(Cube.Orientations[Piece], Table.Moves[Move]);
+			}
+			Cube.Move = INDEX_NONE;
+			Cube.Time = -Random.FRandRange(0.0f, MaxIdleTime);
+		} else {
+			SliceRotation = FQuat(Table.MoveAxes[Move], Table.MoveAngles[Move] * FCTween::Ease(Alpha, EFCEase::OutBack));
+		}
+
+		for (int32 x = 0; x < Table.SliceSizes[Move]; x++) {
+			SetPieceTransform(Cube, CubeIndex, Table.SliceSlots[Move][x], SliceRotation);
+		}
+		OutFirstDirty = FMath::Min(OutFirstDirty, CubeIndex * FVRubiksCrowdMoveTable::NumPieces);
+		OutLastDirty = (CubeIndex + 1) * FVRubiksCrowdMoveTable::NumPieces - 1;
+	}
+}
+
+// Sets default values
+AVRubiksCubeCrowd::AVRubiksCubeCrowd()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	NumCubes = 1000;
+	Columns = 40;
+	Spacing = 1.5f;
+	MoveDuration = 0.4f;
+	MaxIdleTime = 1.0f;
+	StickerMaterial = nullptr;
+	StickerMaterialInstance = nullptr;
+	FaceColors = UVRubiksColorSchemeLibrary::GetSchemeColors(EVRubiksColorScheme::Standard);
+
+	PieceInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(FName("Piece Instances"));
+	PieceInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	PieceInstances->NumCustomDataFloats = 6;
+	SetRootComponent(PieceInstances);
+}
+
+void AVRubiksCubeCrowd::BeginPlay()
+{
+	Super::BeginPlay();
+	Build();
+}
+
+void AVRubiksCubeCrowd::Build()
+{
+	PieceInstances->ClearInstances();
+	if (!PieceClass) {
+		return;
+	}
+
+	const AVRubiksPiece* PieceDefaults = GetDefault<AVRubiksPiece>(PieceClass);
+	PieceInstances->SetStaticMesh(PieceDefaults->GetStaticMesh());
+	if (StickerMaterial) {
+		StickerMaterialInstance = UMaterialInstanceDynamic::Create(StickerMaterial, this);
+		for (int32 x = 0; x < FMath::Min(FaceColors.Num(), 6); x++) {
+			StickerMaterialInstance->SetVectorParameterValue(UVRubiksColorSchemeLibrary::GetPaletteParameterName(x), FaceColors[x]);
+		}
+		for (int32 Face = 0; Face < 6; Face++) {
+			PieceInstances->SetMaterial(Face, StickerMaterialInstance);
+		}
+	}
+
+	Simulation.MoveDuration = MoveDuration;
+	Simulation.MaxIdleTime = MaxIdleTime;
+	Simulation.Reset(NumCubes, Columns, FVRubiksCubeLayout::GetPieceWidth(PieceDefaults->GetStaticMesh()), Spacing, GetUniqueID());
+	PieceInstances->AddInstances(Simulation.GetTransforms(), false);
+
+	//Stickers travel with their piece, so the custom data is written once
+	const FVRubiksCrowdMoveTable& Table = FVRubiksCrowdMoveTable::Get();
+	for (int32 Instance = 0; Instance < Simulation.GetTransforms().Num(); Instance++) {
+		const uint8 FaceMask = Table.SlotFaceMasks[Instance % FVRubiksCrowdMoveTable::NumPieces];
+		for (int32 Face = 0; Face < 6; Face++) {
+			PieceInstances->SetCustomDataValue(Instance, Face, (FaceMask & (1 << Face)) ? (float)Face : (float)STICKER_NONE, false);
+		}
+	}
+	PieceInstances->MarkRenderStateDirty();
+}
+
+void AVRubiksCubeCrowd::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	int32 FirstDirty, LastDirty;
+	Simulation.Tick(DeltaSeconds, FirstDirty, LastDirty);
+	if (FirstDirty > LastDirty || Simulation.GetTransforms().Num() != PieceInstances->GetInstanceCount()) {
+		return;
+	}
+
+	//Every moving piece of every cube in one call and one render state update
+	DirtyTransforms.Reset();
+	DirtyTransforms.Append(Simulation.GetTransforms().GetData() + FirstDirty, LastDirty - FirstDirty + 1);
+	PieceInstances->BatchUpdateInstancesTransforms(FirstDirty, DirtyTransforms, false, true, true);
+}
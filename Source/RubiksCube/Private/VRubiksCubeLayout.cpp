@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VRubiksCubeLayout.h"
+#include "VRubiksCubeModel.h"
+#include "Engine/StaticMesh.h"
+#include "UObject/ObjectKey.h"
+
+namespace VRubiksCubeLayout
+{
+	static FCriticalSection CacheLock;
+	static TMap<TPair<int32, FObjectKey>, TSharedRef<const FVRubiksCubeLayout>> Cache;
+}
+
+uint8 FVRubiksCubeLayout::GetFaceMask(const FIntVector& Cell, int32 CubeSize)
+{
+	uint8 Mask = 0;
+	Mask |= Cell.X == 0 ? Front : 0;
+	Mask |= Cell.X == CubeSize - 1 ? Back : 0;
+	Mask |= Cell.Y == 0 ? Left : 0;
+	Mask |= Cell.Y == CubeSize - 1 ? Right : 0;
+	Mask |= Cell.Z == CubeSize - 1 ? Up : 0;
+	Mask |= Cell.Z == 0 ? Down : 0;
+	return Mask;
+}
+
+float FVRubiksCubeLayout::GetPieceWidth(const UStaticMesh* PieceMesh)
+{
+	return PieceMesh ? PieceMesh->GetBounds().BoxExtent.X * 2 : 0.0f;
+}
+
+TSharedRef<const FVRubiksCubeLayout> FVRubiksCubeLayout::Get(int32 CubeSize, const UStaticMesh* PieceMesh)
+{
+	const TPair<int32, FObjectKey> Key(CubeSize, FObjectKey(PieceMesh));
+
+	FScopeLock Lock(&VRubiksCubeLayout::CacheLock);
+	if (const TSharedRef<const FVRubiksCubeLayout>* Found = VRubiksCubeLayout::Cache.Find(Key)) {
+		return *Found;
+	}
+
+	TSharedRef<FVRubiksCubeLayout> Layout = MakeShared<FVRubiksCubeLayout>();
+	Layout->Size = CubeSize;
+	Layout->PieceWidth = GetPieceWidth(PieceMesh);
+	//Offset it a little because the origin of the piece it's in the center of the mesh
+	Layout->Center = FVector((Layout->PieceWidth * CubeSize / 2) - (Layout->PieceWidth / 2));
+
+	FVRubiksCubeModel::GetSurfaceCells(CubeSize, Layout->Cells);
+	Layout->Offsets.SetNumUninitialized(Layout->Cells.Num());
+	Layout->FaceMasks.SetNumUninitialized(Layout->Cells.Num());
+	for (int32 Index = 0; Index < Layout->Cells.Num(); Index++) {
+		Layout->Offsets[Index] = FVector(Layout->Cells[Index]) * Layout->PieceWidth;
+		Layout->FaceMasks[Index] = GetFaceMask(Layout->Cells[Index], CubeSize);
+	}
+
+	VRubiksCubeLayout::Cache.Add(Key, Layout);
+	return Layout;
+}
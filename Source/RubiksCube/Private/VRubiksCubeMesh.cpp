@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VRubiksCubeMesh.h"
+#include "VRubiksCubeLayout.h"
+
+void FVRubiksCubeMesh::Build(const FVRubiksCubeLayout& Layout, const FColor (&FaceColors)[6], const FColor& InnerColor)
+{
+	//Faces in the order of the layout face bits: Front (-X), Back (+X), Left (-Y), Right (+Y), Up (+Z), Down (-Z)
+	static const FVector FaceNormals[6] = {
+		FVector(-1, 0, 0), FVector(1, 0, 0), FVector(0, -1, 0), FVector(0, 1, 0), FVector(0, 0, 1), FVector(0, 0, -1)
+	};
+
+	const float HalfWidth = Layout.PieceWidth / 2;
+	for (int32 Face = 0; Face < 6; Face++) {
+		const FVector& Normal = FaceNormals[Face];
+		const FVector U = FMath::Abs(Normal.Z) > 0.5f ? FVector(1, 0, 0) : FVector(0, 0, 1);
+		const FVector V = Normal ^ U;
+
+		//Corners go around the normal (U ^ V == Normal)
+		const FVector Corners[4] = { -U - V, U - V, U + V, -U + V };
+		for (int32 Corner = 0; Corner < 4; Corner++) {
+			LocalVertices[Face * 4 + Corner] = (Normal + Corners[Corner]) * HalfWidth;
+			LocalNormals[Face * 4 + Corner] = Normal;
+		}
+	}
+
+	const int32 NumCubePieces = Layout.Cells.Num();
+	Vertices.SetNumUninitialized(NumCubePieces * VerticesPerPiece);
+	Normals.SetNumUninitialized(NumCubePieces * VerticesPerPiece);
+	UVs.SetNumUninitialized(NumCubePieces * VerticesPerPiece);
+	Colors.SetNumUninitialized(NumCubePieces * VerticesPerPiece);
+	Triangles.SetNumUninitialized(NumCubePieces * 6 * 6);
+
+	static const FVector2D CornerUVs[4] = { FVector2D(0, 1), FVector2D(1, 1), FVector2D(1, 0), FVector2D(0, 0) };
+	int32* Triangle = Triangles.GetData();
+	for (int32 Piece = 0; Piece < NumCubePieces; Piece++) {
+		const int32 FirstVertex = Piece * VerticesPerPiece;
+		for (int32 Face = 0; Face < 6; Face++) {
+			const int32 FaceVertex = FirstVertex + Face * 4;
+			const FColor& Color = (Layout.FaceMasks[Piece] & (1 << Face)) ? FaceColors[Face] : InnerColor;
+			for (int32 Corner = 0; Corner < 4; Corner++) {
+				UVs[FaceVertex + Corner] = CornerUVs[Corner];
+				Colors[FaceVertex + Corner] = Color;
+			}
+
+			//Front faces wind clockwise in Unreal
+			*Triangle++ = FaceVertex;
+			*Triangle++ = FaceVertex + 2;
+			*Triangle++ = FaceVertex + 1;
+			*Triangle++ = FaceVertex;
+			*Triangle++ = FaceVertex + 3;
+			*Triangle++ = FaceVertex + 2;
+		}
+
+		SetPieceTransform(Piece, FTransform(Layout.Offsets[Piece]));
+	}
+}
+
+void FVRubiksCubeMesh::Reset()
+{
+	Vertices.Reset();
+	Normals.Reset();
+	UVs.Reset();
+	Colors.Reset();
+	Triangles.Reset();
+}
+
+int32 FVRubiksCubeMesh::NumPieces() const
+{
+	return Vertices.Num() / VerticesPerPiece;
+}
+
+void FVRubiksCubeMesh::SetPieceTransform(int32 PieceIndex, const FTransform& Transform)
+{
+	FVector* PieceVertices = Vertices.GetData() + PieceIndex * VerticesPerPiece;
+	FVector* PieceNormals = Normals.GetData() + PieceIndex * VerticesPerPiece;
+	for (int32 Vertex = 0; Vertex < VerticesPerPiece; Vertex++) {
+		PieceVertices[Vertex] = Transform.TransformPosition(LocalVertices[Vertex]);
+		PieceNormals[Vertex] = Transform.TransformVectorNoScale(LocalNormals[Vertex]);
+	}
+}
+
+void FVRubiksCubeMesh::SetFaceColor(int32 PieceIndex, int32 Face, const FColor& Color)
+{
+	FColor* FaceColors = Colors.GetData() + PieceIndex * VerticesPerPiece + Face * 4;
+	for (int32 Corner = 0; Corner < 4; Corner++) {
+		FaceColors[Corner] = Color;
+	}
+}
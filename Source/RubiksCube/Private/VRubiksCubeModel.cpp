@@ -0,0 +1,384 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VRubiksCubeModel.h"
+
+namespace VRubiksCubeModel
+{
+	//The 24 rotations of a cube plus the result of turning each of them a quarter (1, 2 or 3 times) around each axis
+	struct FOrientationTables
+	{
+		FQuat Orientations[24];
+		uint8 Turn[24][3][4];
+		//Integer rotation matrices (rows) for each axis and quarter count
+		FIntVector Matrices[3][4][3];
+		//Same for each orientation, and the orientation undoing it
+		FIntVector OrientationMatrices[24][3];
+		uint8 Inverse[24];
+
+		FOrientationTables()
+		{
+			int32 Num = 0;
+			Orientations[Num++] = FQuat::Identity;
+			for (int32 Index = 0; Index < Num; Index++) {
+				for (int32 Axis = 0; Axis < 3; Axis++) {
+					FQuat Rotated = FVRubiksMove(Axis, 0, 1).GetRotation() * Orientations[Index];
+					if (Find(Rotated, Num) == INDEX_NONE) {
+						check(Num < 24);
+						Orientations[Num++] = Rotated;
+					}
+				}
+			}
+			check(Num == 24);
+
+			for (int32 Axis = 0; Axis < 3; Axis++) {
+				for (int32 Quarter = 0; Quarter < 4; Quarter++) {
+					FQuat Rotation = FVRubiksMove(Axis, 0, Quarter).GetRotation();
+					for (int32 Index = 0; Index < 24; Index++) {
+						Turn[Index][Axis][Quarter] = (uint8)Find(Rotation * Orientations[Index], 24);
+					}
+					MakeMatrix(Rotation, Matrices[Axis][Quarter]);
+				}
+			}
+
+			for (int32 Index = 0; Index < 24; Index++) {
+				MakeMatrix(Orientations[Index], OrientationMatrices[Index]);
+				Inverse[Index] = (uint8)Find(Orientations[Index].Inverse(), 24);
+			}
+		}
+
+		static void MakeMatrix(const FQuat& Rotation, FIntVector* OutRows)
+		{
+			FVector Columns[3] = {
+				Rotation.RotateVector(FVector::XAxisVector),
+				Rotation.RotateVector(FVector::YAxisVector),
+				Rotation.RotateVector(FVector::ZAxisVector)
+			};
+			for (int32 Row = 0; Row < 3; Row++) {
+				OutRows[Row] = FIntVector(
+					FMath::RoundToInt(Columns[0][Row]),
+					FMath::RoundToInt(Columns[1][Row]),
+					FMath::RoundToInt(Columns[2][Row]));
+			}
+		}
+
+		int32 Find(const FQuat& Rotation, int32 Num) const
+		{
+			for (int32 Index = 0; Index < Num; Index++) {
+				if (FMath::Abs(Orientations[Index] | Rotation) > 0.99f) {
+					return Index;
+				}
+			}
+			return INDEX_NONE;
+		}
+	};
+
+	static const FOrientationTables& GetTables()
+	{
+		static const FOrientationTables Tables;
+		return Tables;
+	}
+
+	static FIntVector Multiply(const FIntVector* M, const FIntVector& V)
+	{
+		return FIntVector(
+			M[0].X * V.X + M[0].Y * V.Y + M[0].Z * V.Z,
+			M[1].X * V.X + M[1].Y * V.Y + M[1].Z * V.Z,
+			M[2].X * V.X + M[2].Y * V.Y + M[2].Z * V.Z);
+	}
+
+	static FIntVector Rotate(const FIntVector& V, int32 Axis, int32 Quarter)
+	{
+		return Multiply(GetTables().Matrices[Axis][Quarter & 3], V);
+	}
+
+	//Face of an outward unit vector, in the order of FVRubiksCubeLayout::EFace
+	static int32 GetFaceIndex(const FIntVector& Normal)
+	{
+		if (Normal.X != 0) {
+			return Normal.X < 0 ? 0 : 1;
+		}
+		if (Normal.Y != 0) {
+			return Normal.Y < 0 ? 2 : 3;
+		}
+		return Normal.Z > 0 ? 4 : 5;
+	}
+}
+
+FQuat FVRubiksMove::GetRotation() const
+{
+	return GetAxisRotation(Axis, 90.0f * QuarterTurns);
+}
+
+FQuat FVRubiksMove::GetAxisRotation(int32 Axis, float Degrees)
+{
+	switch (Axis)
+	{
+	case 0:
+		return FRotator(0, 0, Degrees).Quaternion();
+	case 1:
+		return FRotator(Degrees, 0, 0).Quaternion();
+	default:
+		return FRotator(0, Degrees, 0).Quaternion();
+	}
+}
+
+FVRubiksMove FVRubiksMove::Inverse() const
+{
+	return FVRubiksMove(Axis, Layer, -QuarterTurns);
+}
+
+uint16 FVRubiksMove::Pack() const
+{
+	//0 = +1, 1 = -1, 2 = half turn
+	const uint16 TurnCode = QuarterTurns == 1 ? 0 : (QuarterTurns == -1 ? 1 : 2);
+	return (uint16)((Layer & 0x7FF) | ((Axis & 0x3) << 11) | (TurnCode << 13));
+}
+
+bool FVRubiksMove::Unpack(uint16 Packed, FVRubiksMove& OutMove)
+{
+	const uint16 TurnCode = (Packed >> 13) & 0x3;
+	const uint8 PackedAxis = (Packed >> 11) & 0x3;
+	if (TurnCode > 2 || PackedAxis > 2) {
+		return false;
+	}
+
+	OutMove = FVRubiksMove(PackedAxis, Packed & 0x7FF, TurnCode == 0 ? 1 : (TurnCode == 1 ? -1 : 2));
+	return true;
+}
+
+FVRubiksCubeModel::FVRubiksCubeModel()
+	: Size(0)
+{
+}
+
+void FVRubiksCubeModel::Reset(int32 NewSize)
+{
+	Size = NewSize;
+	BuildSlots();
+	ResetToSolved();
+}
+
+void FVRubiksCubeModel::ResetToSolved()
+{
+	Pieces.SetNumUninitialized(SlotToCell.Num());
+	for (int32 Index = 0; Index < SlotToCell.Num(); Index++) {
+		FPiece& Piece = Pieces[Index];
+		Piece.HomeCell = SlotToCell[Index];
+		Piece.Cell = SlotToCell[Index];
+		Piece.Orientation = 0;
+	}
+
+	//Piece N starts in slot N
+	CellToPiece = CellToSlot;
+}
+
+void FVRubiksCubeModel::BuildSlots()
+{
+	GetSurfaceCells(Size, SlotToCell);
+	CellToSlot.Init(INDEX_NONE, Size * Size * Size);
+	for (int32 Slot = 0; Slot < SlotToCell.Num(); Slot++) {
+		const FIntVector& Cell = SlotToCell[Slot];
+		CellToSlot[Cell.X + Size * (Cell.Y + Size * Cell.Z)] = Slot;
+	}
+}
+
+void FVRubiksCubeModel::GetSurfaceCells(int32 CubeSize, TArray<FIntVector>& OutCells)
+{
+	OutCells.Reset(CubeSize * CubeSize * CubeSize - FMath::Max(CubeSize - 2, 0) * FMath::Max(CubeSize - 2, 0) * FMath::Max(CubeSize - 2, 0));
+
+	//Same order as the cube has always spawned its pieces: Y, then X, then Z
+	for (int32 i = 0; i < CubeSize; i++) {
+		for (int32 j = 0; j < CubeSize; j++) {
+			if (i == 0 || i == CubeSize - 1 || j == 0 || j == CubeSize - 1) {
+				//Outer ring, the whole Z column is on the surface
+				for (int32 k = 0; k < CubeSize; k++) {
+					OutCells.Add(FIntVector(j, i, k));
+				}
+			} else {
+				//Inner column, only its two ends
+				OutCells.Add(FIntVector(j, i, 0));
+				OutCells.Add(FIntVector(j, i, CubeSize - 1));
+			}
+		}
+	}
+}
+
+bool FVRubiksCubeModel::IsSurfaceCell(const FIntVector& Cell, int32 CubeSize)
+{
+	return Cell.X == 0 || Cell.X == CubeSize - 1
+		|| Cell.Y == 0 || Cell.Y == CubeSize - 1
+		|| Cell.Z == 0 || Cell.Z == CubeSize - 1;
+}
+
+const FQuat& FVRubiksCubeModel::GetOrientationQuat(uint8 Orientation)
+{
+	return VRubiksCubeModel::GetTables().Orientations[Orientation];
+}
+
+uint8 FVRubiksCubeModel::TurnOrientation(uint8 Orientation, const FVRubiksMove& Move)
+{
+	return VRubiksCubeModel::GetTables().Turn[Orientation][Move.Axis][Move.QuarterTurns & 3];
+}
+
+FIntVector FVRubiksCubeModel::RotateVector(const FIntVector& Vector, int32 Axis, int32 QuarterTurns)
+{
+	return VRubiksCubeModel::Rotate(Vector, Axis, QuarterTurns & 3);
+}
+
+FIntVector FVRubiksCubeModel::RotateByOrientation(uint8 Orientation, const FIntVector& Vector)
+{
+	return VRubiksCubeModel::Multiply(VRubiksCubeModel::GetTables().OrientationMatrices[Orientation], Vector);
+}
+
+uint8 FVRubiksCubeModel::InverseOrientation(uint8 Orientation)
+{
+	return VRubiksCubeModel::GetTables().Inverse[Orientation];
+}
+
+FVRubiksMove FVRubiksCubeModel::ReorientMove(const FVRubiksMove& Move, uint8 Frame, int32 CubeSize)
+{
+	FIntVector Axis(0);
+	Axis[Move.Axis] = 1;
+	const FIntVector Turned = RotateByOrientation(Frame, Axis);
+	const int32 NewAxis = Turned.X != 0 ? 0 : (Turned.Y != 0 ? 1 : 2);
+	const int32 NewLayer = Turned[NewAxis] > 0 ? Move.Layer : CubeSize - 1 - Move.Layer;
+
+	//Positive turns do not share one handedness across axes (they follow the cube's rotators), so find the turn that
+	//matches the reoriented rotation on a vector no quarter turn leaves in place
+	const FIntVector Probe(1, 2, 3);
+	const FIntVector Expected = RotateByOrientation(Frame, RotateVector(RotateByOrientation(InverseOrientation(Frame), Probe), Move.Axis, Move.QuarterTurns));
+	for (int32 QuarterTurns = 1; QuarterTurns < 4; QuarterTurns++) {
+		if (RotateVector(Probe, NewAxis, QuarterTurns) == Expected) {
+			return FVRubiksMove(NewAxis, NewLayer, QuarterTurns == 3 ? -1 : QuarterTurns);
+		}
+	}
+	check(false);
+	return Move;
+}
+
+FQuat FVRubiksCubeModel::GetPieceRotation(int32 Index) const
+{
+	return GetOrientationQuat(Pieces[Index].Orientation);
+}
+
+bool FVRubiksCubeModel::IsValidMove(const FVRubiksMove& Move) const
+{
+	return Move.Axis < 3 && Move.Layer < Size && Move.QuarterTurns != 0 && FMath::Abs(Move.QuarterTurns) <= 2;
+}
+
+int32 FVRubiksCubeModel::GetPieceAtCell(const FIntVector& Cell) const
+{
+	if (Cell.X < 0 || Cell.X >= Size || Cell.Y < 0 || Cell.Y >= Size || Cell.Z < 0 || Cell.Z >= Size) {
+		return INDEX_NONE;
+	}
+	return CellToPiece[Cell.X + Size * (Cell.Y + Size * Cell.Z)];
+}
+
+void FVRubiksCubeModel::GetSlicePieces(const FVRubiksMove& Move, TArray<int32>& OutPieces) const
+{
+	OutPieces.Reset();
+	for (int32 Index = 0; Index < Pieces.Num(); Index++) {
+		if (Pieces[Index].Cell[Move.Axis] == Move.Layer) {
+			OutPieces.Add(Index);
+		}
+	}
+}
+
+void FVRubiksCubeModel::ApplyMove(const FVRubiksMove& Move)
+{
+	check(IsValidMove(Move));
+
+	const VRubiksCubeModel::FOrientationTables& Tables = VRubiksCubeModel::GetTables();
+	const int32 Quarter = Move.QuarterTurns & 3;
+	const FIntVector Offset(Size - 1);
+	for (int32 Index = 0; Index < Pieces.Num(); Index++) {
+		FPiece& Piece = Pieces[Index];
+		if (Piece.Cell[Move.Axis] != Move.Layer) {
+			continue;
+		}
+
+		//Rotate around the cube center using doubled coordinates so even sizes stay on integers
+		const FIntVector Doubled = Piece.Cell * 2 - Offset;
+		Piece.Cell = (VRubiksCubeModel::Rotate(Doubled, Move.Axis, Quarter) + Offset) / 2;
+		Piece.Orientation = Tables.Turn[Piece.Orientation][Move.Axis][Quarter];
+
+		//The slice maps onto itself, every cell it covers gets rewritten
+		CellToPiece[Piece.Cell.X + Size * (Piece.Cell.Y + Size * Piece.Cell.Z)] = Index;
+	}
+}
+
+bool FVRubiksCubeModel::IsSolved() const
+{
+	//Home face shown on each face of the cube, whichever sticker gets there first sets it
+	int32 FaceColors[6] = { INDEX_NONE, INDEX_NONE, INDEX_NONE, INDEX_NONE, INDEX_NONE, INDEX_NONE };
+	for (const FPiece& Piece : Pieces) {
+		for (int32 Axis = 0; Axis < 3; Axis++) {
+			if (Piece.HomeCell[Axis] != 0 && Piece.HomeCell[Axis] != Size - 1) {
+				continue;
+			}
+
+			FIntVector Normal(0);
+			Normal[Axis] = Piece.HomeCell[Axis] == 0 ? -1 : 1;
+			const int32 Color = VRubiksCubeModel::GetFaceIndex(Normal);
+			int32& FaceColor = FaceColors[VRubiksCubeModel::GetFaceIndex(RotateByOrientation(Piece.Orientation, Normal))];
+			if (FaceColor == INDEX_NONE) {
+				FaceColor = Color;
+			} else if (FaceColor != Color) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void FVRubiksCubeModel::Save(FArchive& Ar) const
+{
+	//Slots are stored as 16 bit, enough for every size the cube supports
+	check(SlotToCell.Num() <= MAX_uint16);
+
+	uint16 SerializedSize = (uint16)Size;
+	Ar << SerializedSize;
+	for (const FPiece& Piece : Pieces) {
+		uint16 Slot = (uint16)CellToSlot[Piece.Cell.X + Size * (Piece.Cell.Y + Size * Piece.Cell.Z)];
+		uint8 Orientation = Piece.Orientation;
+		Ar << Slot;
+		Ar << Orientation;
+	}
+}
+
+bool FVRubiksCubeModel::Load(FArchive& Ar)
+{
+	uint16 SerializedSize = 0;
+	Ar << SerializedSize;
+	if (Ar.IsError() || SerializedSize < 2 || SerializedSize > 2047) {
+		return false;
+	}
+
+	Reset(SerializedSize);
+	if (SlotToCell.Num() > MAX_uint16) {
+		return false;
+	}
+
+	TBitArray<> UsedSlots(false, SlotToCell.Num());
+	for (FPiece& Piece : Pieces) {
+		uint16 Slot = 0;
+		uint8 Orientation = 0;
+		Ar << Slot;
+		Ar << Orientation;
+
+		if (Ar.IsError() || Slot >= SlotToCell.Num() || UsedSlots[Slot] || Orientation >= NumOrientations()) {
+			ResetToSolved();
+			return false;
+		}
+		UsedSlots[Slot] = true;
+		Piece.Cell = SlotToCell[Slot];
+		Piece.Orientation = Orientation;
+	}
+
+	for (int32 Index = 0; Index < Pieces.Num(); Index++) {
+		const FIntVector& Cell = Pieces[Index].Cell;
+		CellToPiece[Cell.X + Size * (Cell.Y + Size * Cell.Z)] = Index;
+	}
+	return true;
+}
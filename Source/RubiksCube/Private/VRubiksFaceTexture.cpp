@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VRubiksFaceTexture.h"
+#include "Engine/Texture2D.h"
+
+UTexture2D* FVRubiksFaceTexture::Create(int32 Size)
+{
+	UTexture2D* Texture = UTexture2D::CreateTransient(Size, Size, PF_B8G8R8A8);
+	Texture->Filter = TF_Nearest;
+	Texture->SRGB = true;
+	Texture->UpdateResource();
+	return Texture;
+}
+
+void FVRubiksFaceTexture::UploadRect(UTexture2D* Texture, const FIntRect& Rect, TFunctionRef<FColor(int32 X, int32 Y)> GetTexel)
+{
+	if (Rect.Area() <= 0) {
+		return;
+	}
+
+	const int32 Width = Rect.Width();
+	const int32 Height = Rect.Height();
+	FColor* Data = new FColor[Width * Height];
+	for (int32 Y = 0; Y < Height; Y++) {
+		for (int32 X = 0; X < Width; X++) {
+			Data[Y * Width + X] = GetTexel(Rect.Min.X + X, Rect.Min.Y + Y);
+		}
+	}
+
+	FUpdateTextureRegion2D* Region = new FUpdateTextureRegion2D(Rect.Min.X, Rect.Min.Y, 0, 0, Width, Height);
+	Texture->UpdateTextureRegions(0, 1, Region, Width * sizeof(FColor), sizeof(FColor), reinterpret_cast<uint8*>(Data), [](uint8* SrcData, const FUpdateTextureRegion2D* Regions)
+	{
+		delete[] reinterpret_cast<FColor*>(SrcData);
+		delete Regions;
+	});
+}
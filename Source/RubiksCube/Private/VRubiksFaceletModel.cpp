@@ -0,0 +1,196 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VRubiksFaceletModel.h"
+
+FVRubiksFaceletModel::FVRubiksFaceletModel()
+	: Size(0)
+{
+	FMemory::Memzero(FaceRotations);
+}
+
+void FVRubiksFaceletModel::Reset(int32 NewSize)
+{
+	Size = NewSize;
+	for (int32 Face = 0; Face < 6; Face++) {
+		Faces[Face].Init((uint8)Face, Size * Size);
+		FaceRotations[Face] = 0;
+	}
+	BandColors.Reset(Size * 4);
+}
+
+void FVRubiksFaceletModel::SetFromModel(const FVRubiksCubeModel& Model)
+{
+	Reset(Model.GetSize());
+	for (int32 Index = 0; Index < Model.NumPieces(); Index++) {
+		const FVRubiksCubeModel::FPiece& Piece = Model.GetPiece(Index);
+		for (int32 Axis = 0; Axis < 3; Axis++) {
+			if (Piece.HomeCell[Axis] != 0 && Piece.HomeCell[Axis] != Size - 1) {
+				continue;
+			}
+
+			//The sticker keeps its home face as color and ends up on the face its normal turns to
+			FIntVector Normal(0);
+			Normal[Axis] = Piece.HomeCell[Axis] == 0 ? -1 : 1;
+			const FIntVector Turned = FVRubiksCubeModel::RotateByOrientation(Piece.Orientation, Normal);
+			const int32 TurnedAxis = Turned.X != 0 ? 0 : (Turned.Y != 0 ? 1 : 2);
+			const int32 Face = GetFace(TurnedAxis, Turned[TurnedAxis] > 0);
+
+			int32 ColAxis, RowAxis;
+			GetFaceAxes(Face, ColAxis, RowAxis);
+			SetSticker(Face, Piece.Cell[ColAxis], Piece.Cell[RowAxis], (uint8)GetFace(Axis, Normal[Axis] > 0));
+		}
+	}
+}
+
+int32 FVRubiksFaceletModel::GetFace(int32 Axis, bool bPositive)
+{
+	//Front/Back on X, Left/Right on Y, then Up (+Z) before Down (-Z)
+	static const int32 AxisFaces[3][2] = { { 0, 1 }, { 2, 3 }, { 5, 4 } };
+	return AxisFaces[Axis][bPositive ? 1 : 0];
+}
+
+int32 FVRubiksFaceletModel::GetFaceAxis(int32 Face)
+{
+	return Face / 2;
+}
+
+bool FVRubiksFaceletModel::IsFacePositive(int32 Face)
+{
+	return Face == 1 || Face == 3 || Face == 4;
+}
+
+void FVRubiksFaceletModel::GetFaceAxes(int32 Face, int32& OutColAxis, int32& OutRowAxis)
+{
+	OutColAxis = (GetFaceAxis(Face) + 1) % 3;
+	OutRowAxis = (GetFaceAxis(Face) + 2) % 3;
+}
+
+FIntPoint FVRubiksFaceletModel::GetStoragePoint(int32 Face, int32 Col, int32 Row) const
+{
+	//Rotate by -FaceRotation quarter turns around the face center
+	const int32 Last = Size - 1;
+	switch ((4 - FaceRotations[Face]) & 3)
+	{
+	case 1:
+		return FIntPoint(Last - Row, Col);
+	case 2:
+		return FIntPoint(Last - Col, Last - Row);
+	case 3:
+		return FIntPoint(Row, Last - Col);
+	default:
+		return FIntPoint(Col, Row);
+	}
+}
+
+uint8 FVRubiksFaceletModel::GetSticker(int32 Face, int32 Col, int32 Row) const
+{
+	const FIntPoint Point = GetStoragePoint(Face, Col, Row);
+	return Faces[Face][Point.Y * Size + Point.X];
+}
+
+void FVRubiksFaceletModel::SetSticker(int32 Face, int32 Col, int32 Row, uint8 Color)
+{
+	const FIntPoint Point = GetStoragePoint(Face, Col, Row);
+	Faces[Face][Point.Y * Size + Point.X] = Color;
+}
+
+bool FVRubiksFaceletModel::IsValidMove(const FVRubiksMove& Move) const
+{
+	return Move.Axis < 3 && Move.Layer < Size && Move.QuarterTurns != 0 && FMath::Abs(Move.QuarterTurns) <= 2;
+}
+
+FIntVector FVRubiksFaceletModel::GetBandCell(int32 Face, const FVRubiksMove& Move, int32 T) const
+{
+	const int32 FaceAxis = GetFaceAxis(Face);
+	FIntVector Cell;
+	Cell[FaceAxis] = IsFacePositive(Face) ? Size - 1 : 0;
+	Cell[Move.Axis] = Move.Layer;
+	Cell[3 - FaceAxis - Move.Axis] = T;
+	return Cell;
+}
+
+void FVRubiksFaceletModel::ApplyMove(const FVRubiksMove& Move)
+{
+	check(IsValidMove(Move));
+
+	//Read the whole band first, its stickers move onto each other
+	BandColors.Reset();
+	for (int32 Face = 0; Face < 6; Face++) {
+		if (GetFaceAxis(Face) == Move.Axis) {
+			continue;
+		}
+
+		int32 ColAxis, RowAxis;
+		GetFaceAxes(Face, ColAxis, RowAxis);
+		for (int32 T = 0; T < Size; T++) {
+			const FIntVector Cell = GetBandCell(Face, Move, T);
+			BandColors.Add(GetSticker(Face, Cell[ColAxis], Cell[RowAxis]));
+		}
+	}
+
+	//Then write each sticker where the rotation takes its cell and normal, with doubled coordinates like the piece model
+	const FIntVector Offset(Size - 1);
+	int32 BandIndex = 0;
+	for (int32 Face = 0; Face < 6; Face++) {
+		const int32 FaceAxis = GetFaceAxis(Face);
+		if (FaceAxis == Move.Axis) {
+			continue;
+		}
+
+		FIntVector Normal(0);
+		Normal[FaceAxis] = IsFacePositive(Face) ? 1 : -1;
+		const FIntVector RotatedNormal = FVRubiksCubeModel::RotateVector(Normal, Move.Axis, Move.QuarterTurns);
+		const int32 DestAxis = RotatedNormal.X != 0 ? 0 : (RotatedNormal.Y != 0 ? 1 : 2);
+		const int32 DestFace = GetFace(DestAxis, RotatedNormal[DestAxis] > 0);
+
+		int32 ColAxis, RowAxis;
+		GetFaceAxes(DestFace, ColAxis, RowAxis);
+		for (int32 T = 0; T < Size; T++) {
+			const FIntVector Doubled = GetBandCell(Face, Move, T) * 2 - Offset;
+			const FIntVector Cell = (FVRubiksCubeModel::RotateVector(Doubled, Move.Axis, Move.QuarterTurns) + Offset) / 2;
+			SetSticker(DestFace, Cell[ColAxis], Cell[RowAxis], BandColors[BandIndex++]);
+		}
+	}
+
+	//An outer layer also turns a whole face, which only changes how its storage is read
+	if (Move.Layer == 0 || Move.Layer == Size - 1) {
+		int32 ColAxis, RowAxis;
+		GetFaceAxes(GetFace(Move.Axis, false), ColAxis, RowAxis);
+		FIntVector ColVector(0);
+		ColVector[ColAxis] = 1;
+		const int32 Direction = FVRubiksCubeModel::RotateVector(ColVector, Move.Axis, 1)[RowAxis];
+
+		const int32 Face = GetFace(Move.Axis, Move.Layer == Size - 1);
+		FaceRotations[Face] = (FaceRotations[Face] + Direction * Move.QuarterTurns) & 3;
+	}
+}
+
+bool FVRubiksFaceletModel::IsSolved() const
+{
+	for (int32 Face = 0; Face < 6; Face++) {
+		const uint8* Data = Faces[Face].GetData();
+		for (int32 Index = 1; Index < Faces[Face].Num(); Index++) {
+			if (Data[Index] != Data[0]) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+FIntRect FVRubiksFaceletModel::GetBandRect(int32 Face, const FVRubiksMove& Move) const
+{
+	if (GetFaceAxis(Face) == Move.Axis) {
+		return FIntRect();
+	}
+
+	//The band is a straight line on the face, so its two ends give the rect in storage space
+	int32 ColAxis, RowAxis;
+	GetFaceAxes(Face, ColAxis, RowAxis);
+	const FIntVector First = GetBandCell(Face, Move, 0);
+	const FIntVector Last = GetBandCell(Face, Move, Size - 1);
+	const FIntPoint A = GetStoragePoint(Face, First[ColAxis], First[RowAxis]);
+	const FIntPoint B = GetStoragePoint(Face, Last[ColAxis], Last[RowAxis]);
+	return FIntRect(A.ComponentMin(B), A.ComponentMax(B) + FIntPoint(1, 1));
+}
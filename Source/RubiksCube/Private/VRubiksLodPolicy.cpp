@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VRubiksLodPolicy.h"
+#include "RubiksCube.h"
+
+namespace VRubiksLodPolicy
+{
+	static const TCHAR* GetLodName(EVRubiksPieceLod Lod)
+	{
+		switch (Lod)
+		{
+		case EVRubiksPieceLod::Stickers:
+			return TEXT("Stickers");
+		case EVRubiksPieceLod::Faces:
+			return TEXT("Faces");
+		default:
+			return TEXT("Full");
+		}
+	}
+
+	//Sweeps the screen size down then back up, so the hysteresis shows in the output
+	static void PrintTable(const TArray<FString>& Args)
+	{
+		FVRubiksLodPolicy Policy;
+		if (Args.Num() > 0) {
+			Policy.StickersScreenSize = FCString::Atof(*Args[0]);
+		}
+		if (Args.Num() > 1) {
+			Policy.FacesScreenSize = FCString::Atof(*Args[1]);
+		}
+
+		static const float ScreenSizes[] = { 0.1f, 0.05f, 0.03f, 0.02f, 0.015f, 0.01f, 0.007f, 0.006f, 0.005f, 0.003f, 0.001f };
+		EVRubiksPieceLod Lod = EVRubiksPieceLod::Full;
+		for (int32 Pass = 0; Pass < 2; Pass++) {
+			for (int32 x = 0; x < UE_ARRAY_COUNT(ScreenSizes); x++) {
+				const float ScreenSize = ScreenSizes[Pass == 0 ? x : UE_ARRAY_COUNT(ScreenSizes) - 1 - x];
+				Lod = Policy.Select(ScreenSize, Lod);
+				UE_LOG(LogRubiks, Display, TEXT("LOD %s: screen size %.4f -> %s"), Pass == 0 ? TEXT("shrinking") : TEXT("growing"), ScreenSize, GetLodName(Lod));
+			}
+		}
+	}
+
+	static FAutoConsoleCommand LodTableCommand(
+		TEXT("Rubiks.LodTable"),
+		TEXT("Logs the piece representation picked at each screen size. Usage: Rubiks.LodTable [StickersScreenSize] [FacesScreenSize]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&PrintTable));
+}
+
+FVRubiksLodPolicy::FVRubiksLodPolicy()
+	: StickersScreenSize(0.02f)
+	, FacesScreenSize(0.006f)
+	, Hysteresis(0.25f)
+{
+}
+
+EVRubiksPieceLod FVRubiksLodPolicy::Select(float PieceScreenSize, EVRubiksPieceLod CurrentLod) const
+{
+	//The threshold of the level currently shown is raised, leaving it takes a clearly bigger piece
+	const float Scale = 1.0f + Hysteresis;
+	const float FacesLimit = CurrentLod == EVRubiksPieceLod::Faces ? FacesScreenSize * Scale : FacesScreenSize;
+	const float StickersLimit = CurrentLod != EVRubiksPieceLod::Full ? StickersScreenSize * Scale : StickersScreenSize;
+
+	if (PieceScreenSize < FacesLimit) {
+		return EVRubiksPieceLod::Faces;
+	}
+	if (PieceScreenSize < StickersLimit) {
+		return EVRubiksPieceLod::Stickers;
+	}
+	return EVRubiksPieceLod::Full;
+}
+
+float FVRubiksLodPolicy::GetPieceScreenSize(float PieceWidth, float Distance, float FOVDegrees)
+{
+	const float VisibleWidth = 2.0f * FMath::Max(Distance, KINDA_SMALL_NUMBER) * FMath::Tan(FMath::DegreesToRadians(FMath::Clamp(FOVDegrees, 1.0f, 170.0f)) / 2);
+	return PieceWidth / VisibleWidth;
+}
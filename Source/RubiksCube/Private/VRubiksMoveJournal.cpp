@@ -0,0 +1,219 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VRubiksMoveJournal.h"
+#include "VRubiksCubeModel.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace VRubiksMoveJournal
+{
+	static constexpr uint32 SnapshotMagic = 0x534B4252; //RBKS
+	static constexpr uint32 JournalMagic = 0x4A4B4252; //RBKJ
+	static constexpr uint16 Version = 1;
+	static constexpr uint16 StepFlag = 0x8000;
+
+	static TArray<uint8> MakeJournalHeader(uint32 Generation)
+	{
+		TArray<uint8> Header;
+		FMemoryWriter Writer(Header);
+		uint32 Magic = JournalMagic;
+		uint16 HeaderVersion = Version;
+		Writer << Magic << HeaderVersion << Generation;
+		return Header;
+	}
+
+	//Snapshot: magic, version, generation, steps, crc, model
+	static bool LoadSnapshot(const FString& Path, FVRubiksCubeModel& OutModel, uint32& OutGeneration, int32& OutSteps)
+	{
+		TArray<uint8> SnapshotData;
+		if (!FFileHelper::LoadFileToArray(SnapshotData, *Path, FILEREAD_Silent)) {
+			return false;
+		}
+
+		FMemoryReader SnapshotReader(SnapshotData);
+		uint32 Magic = 0;
+		uint16 SnapshotVersion = 0;
+		uint32 Crc = 0;
+		SnapshotReader << Magic << SnapshotVersion << OutGeneration << OutSteps << Crc;
+		const int64 PayloadOffset = SnapshotReader.Tell();
+		if (SnapshotReader.IsError() || Magic != SnapshotMagic || SnapshotVersion != Version
+			|| FCrc::MemCrc32(SnapshotData.GetData() + PayloadOffset, SnapshotData.Num() - PayloadOffset) != Crc) {
+			return false;
+		}
+		return OutModel.Load(SnapshotReader);
+	}
+}
+
+FVRubiksMoveJournal::FVRubiksMoveJournal(const FString& InDirectory, const FString& InName)
+	: Generation(0)
+	, EntriesSinceSnapshot(0)
+	, WriterPipe(TEXT("RubiksMoveJournal"))
+{
+	SnapshotPath = FPaths::Combine(InDirectory, InName + TEXT(".snapshot"));
+	OldSnapshotPath = SnapshotPath + TEXT(".old");
+	JournalPath = FPaths::Combine(InDirectory, InName + TEXT(".journal"));
+	PendingEntries.Reserve(BatchSize);
+
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FVRubiksMoveJournal::Tick), FlushIntervalSeconds);
+}
+
+FVRubiksMoveJournal::~FVRubiksMoveJournal()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+	Flush();
+
+	//Close the journal on the writer so the handle is never shared between threads
+	LastWrite = WriterPipe.Launch(UE_SOURCE_LOCATION, [this]()
+	{
+		JournalHandle.Reset();
+	});
+	LastWrite.Wait();
+}
+
+bool FVRubiksMoveJournal::Recover(FVRubiksCubeModel& OutModel, int32& OutSteps)
+{
+	using namespace VRubiksMoveJournal;
+
+	//A compaction cut short leaves the previous snapshot aside, its journal has not been restarted yet
+	FVRubiksCubeModel Model;
+	uint32 SnapshotGeneration = 0;
+	int32 Steps = 0;
+	if (!LoadSnapshot(SnapshotPath, Model, SnapshotGeneration, Steps) && !LoadSnapshot(OldSnapshotPath, Model, SnapshotGeneration, Steps)) {
+		return false;
+	}
+
+	//Replay the journal tail, but only if it continues this snapshot
+	TArray<uint8> JournalData;
+	if (FFileHelper::LoadFileToArray(JournalData, *JournalPath, FILEREAD_Silent)) {
+		FMemoryReader JournalReader(JournalData);
+		uint32 JournalGeneration = 0;
+		uint16 JournalVersion = 0;
+		uint32 Magic = 0;
+		JournalReader << Magic << JournalVersion << JournalGeneration;
+		if (!JournalReader.IsError() && Magic == JournalMagic && JournalVersion == Version && JournalGeneration == SnapshotGeneration) {
+			//A torn last entry (odd trailing byte) is simply ignored
+			while (JournalReader.TotalSize() - JournalReader.Tell() >= (int64)sizeof(uint16)) {
+				uint16 Entry = 0;
+				JournalReader << Entry;
+
+				FVRubiksMove Move;
+				if (!FVRubiksMove::Unpack(Entry & ~StepFlag, Move) || !Model.IsValidMove(Move)) {
+					break;
+				}
+				Model.ApplyMove(Move);
+				if (Entry & StepFlag) {
+					Steps++;
+				}
+			}
+		}
+	}
+
+	Generation = SnapshotGeneration;
+	OutModel = MoveTemp(Model);
+	OutSteps = Steps;
+	return true;
+}
+
+void FVRubiksMoveJournal::Append(const FVRubiksMove& Move, bool bCountsAsStep)
+{
+	PendingEntries.Add(Move.Pack() | (bCountsAsStep ? VRubiksMoveJournal::StepFlag : 0));
+	EntriesSinceSnapshot++;
+
+	if (PendingEntries.Num() >= BatchSize) {
+		Flush();
+	}
+}
+
+void FVRubiksMoveJournal::Flush()
+{
+	if (PendingEntries.Num() == 0) {
+		return;
+	}
+
+	TArray<uint16> Batch = MoveTemp(PendingEntries);
+	PendingEntries.Reset(BatchSize);
+
+	LastWrite = WriterPipe.Launch(UE_SOURCE_LOCATION, [this, Batch = MoveTemp(Batch)]()
+	{
+		if (!JournalHandle) {
+			//First write after startup: keep appending to the journal of the current snapshot
+			IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+			if (!PlatformFile.FileExists(*JournalPath)) {
+				return;
+			}
+			JournalHandle.Reset(PlatformFile.OpenWrite(*JournalPath, true));
+			if (!JournalHandle) {
+				return;
+			}
+		}
+
+		JournalHandle->Write(reinterpret_cast<const uint8*>(Batch.GetData()), Batch.Num() * sizeof(uint16));
+		JournalHandle->Flush();
+	});
+}
+
+void FVRubiksMoveJournal::Compact(const FVRubiksCubeModel& Model, int32 Steps)
+{
+	using namespace VRubiksMoveJournal;
+
+	//Moves already buffered belong to the previous snapshot
+	PendingEntries.Reset();
+	EntriesSinceSnapshot = 0;
+	Generation++;
+
+	//Serializing a few kilobytes is cheap, only the file operations are deferred
+	TArray<uint8> Payload;
+	FMemoryWriter PayloadWriter(Payload);
+	Model.Save(PayloadWriter);
+
+	TArray<uint8> SnapshotData;
+	FMemoryWriter SnapshotWriter(SnapshotData);
+	uint32 Magic = SnapshotMagic;
+	uint16 SnapshotVersion = Version;
+	uint32 SnapshotGeneration = Generation;
+	uint32 Crc = FCrc::MemCrc32(Payload.GetData(), Payload.Num());
+	SnapshotWriter << Magic << SnapshotVersion << SnapshotGeneration << Steps << Crc;
+	SnapshotWriter.Serialize(Payload.GetData(), Payload.Num());
+
+	LastWrite = WriterPipe.Launch(UE_SOURCE_LOCATION, [this, SnapshotData = MoveTemp(SnapshotData), SnapshotGeneration]()
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		JournalHandle.Reset();
+
+		//Write the snapshot next to the old one and swap it in. The old snapshot only steps aside, so a crash at any point
+		//leaves one to recover from, and its journal is only restarted once the new snapshot is in place
+		const FString TempPath = SnapshotPath + TEXT(".tmp");
+		bool bSwapped = FFileHelper::SaveArrayToFile(SnapshotData, *TempPath);
+		if (bSwapped && PlatformFile.FileExists(*SnapshotPath)) {
+			PlatformFile.DeleteFile(*OldSnapshotPath);
+			bSwapped = PlatformFile.MoveFile(*OldSnapshotPath, *SnapshotPath);
+		}
+		if (bSwapped && !PlatformFile.MoveFile(*SnapshotPath, *TempPath)) {
+			PlatformFile.MoveFile(*SnapshotPath, *OldSnapshotPath);
+			bSwapped = false;
+		}
+		if (!bSwapped) {
+			//The moves that follow no longer continue the old snapshot, drop its journal rather than replay them on it
+			PlatformFile.DeleteFile(*JournalPath);
+			return;
+		}
+
+		JournalHandle.Reset(PlatformFile.OpenWrite(*JournalPath, false));
+		if (JournalHandle) {
+			TArray<uint8> Header = MakeJournalHeader(SnapshotGeneration);
+			JournalHandle->Write(Header.GetData(), Header.Num());
+			JournalHandle->Flush();
+		}
+		PlatformFile.DeleteFile(*OldSnapshotPath);
+	});
+}
+
+bool FVRubiksMoveJournal::Tick(float DeltaTime)
+{
+	Flush();
+	return true;
+}
@@ -2,6 +2,7 @@
 
 
 #include "VRubiksPiece.h"
+#include "VRubiksCubeLayout.h"
 
 // Sets default values
 AVRubiksPiece::AVRubiksPiece()
@@ -9,6 +10,10 @@ AVRubiksPiece::AVRubiksPiece()
 	PrimaryActorTick.bCanEverTick = false;
 	StaticMeshComponent = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Static Mesh"));
 	SetRootComponent(StaticMeshComponent);
+
+	//The cube picks its pieces analytically, no physics body to move along with every turn
+	StaticMeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	StaticMeshComponent->SetGenerateOverlapEvents(false);
 }
 
 void AVRubiksPiece::SetFaceMaterial(int32 Index, UMaterialInstance* Material)
@@ -16,15 +21,52 @@ void AVRubiksPiece::SetFaceMaterial(int32 Index, UMaterialInstance* Material)
 	StaticMeshComponent->SetMaterial(Index, Material);
 }
 
+void AVRubiksPiece::ResetFaceMaterials()
+{
+	//The class defaults hold the materials a Blueprint sets on the mesh, the face materials only ever go on top
+	const UStaticMeshComponent* DefaultComponent = GetDefault<AVRubiksPiece>(GetClass())->GetMeshComponent();
+	StaticMeshComponent->EmptyOverrideMaterials();
+	for (int32 Slot = 0; Slot < DefaultComponent->OverrideMaterials.Num(); Slot++) {
+		if (DefaultComponent->OverrideMaterials[Slot]) {
+			StaticMeshComponent->SetMaterial(Slot, DefaultComponent->OverrideMaterials[Slot]);
+		}
+	}
+}
+
+void AVRubiksPiece::SetStickerData(int32 Face, float Value)
+{
+	StaticMeshComponent->SetCustomPrimitiveDataFloat(Face, Value);
+}
+
+void AVRubiksPiece::SetPooled(bool bPooled)
+{
+	if (bPooled) {
+		DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+		ResetFaceMaterials();
+	}
+
+	SetActorHiddenInGame(bPooled);
+}
+
 // Called when the game starts or when spawned
 void AVRubiksPiece::BeginPlay()
 {
 	Super::BeginPlay();
 }
 
-float AVRubiksPiece::GetSideWidth()
+float AVRubiksPiece::GetSideWidth() const
+{
+	return FVRubiksCubeLayout::GetPieceWidth(GetStaticMesh());
+}
+
+UStaticMesh* AVRubiksPiece::GetStaticMesh() const
+{
+	return StaticMeshComponent->GetStaticMesh();
+}
+
+UStaticMeshComponent* AVRubiksPiece::GetMeshComponent() const
 {
-	return StaticMeshComponent->GetStaticMesh()->GetBounds().BoxExtent.X*2;
+	return StaticMeshComponent;
 }
 
 
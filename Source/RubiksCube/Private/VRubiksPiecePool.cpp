@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VRubiksPiecePool.h"
+#include "VRubiksPiece.h"
+
+AVRubiksPiece* UVRubiksPiecePool::SpawnPiece(TSubclassOf<AVRubiksPiece> PieceClass)
+{
+	FActorSpawnParameters Params;
+	Params.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	AVRubiksPiece* NewPiece = GetWorld()->SpawnActor<AVRubiksPiece>(PieceClass, FVector::ZeroVector, FRotator(0.0f, 0.0f, 0.0f), Params);
+	if (NewPiece) {
+		NewPiece->SetPooled(true);
+	}
+	return NewPiece;
+}
+
+AVRubiksPiece* UVRubiksPiecePool::Acquire(TSubclassOf<AVRubiksPiece> PieceClass, AActor* Owner)
+{
+	AVRubiksPiece* Piece = nullptr;
+	if (FVRubiksPieceList* List = FreePieces.Find(PieceClass.Get())) {
+		//Pieces can still be destroyed from outside (e.g. level streaming), skip those
+		while (!Piece && List->Pieces.Num() > 0) {
+			Piece = List->Pieces.Pop(false);
+			if (!IsValid(Piece)) {
+				Piece = nullptr;
+			}
+		}
+	}
+
+	if (!Piece) {
+		Piece = SpawnPiece(PieceClass);
+		if (!Piece) {
+			return nullptr;
+		}
+	}
+
+	Piece->SetOwner(Owner);
+	Piece->SetPooled(false);
+	return Piece;
+}
+
+void UVRubiksPiecePool::Release(AVRubiksPiece* Piece)
+{
+	if (!IsValid(Piece)) {
+		return;
+	}
+
+	Piece->SetOwner(nullptr);
+	Piece->SetPooled(true);
+	FreePieces.FindOrAdd(Piece->GetClass()).Pieces.Add(Piece);
+}
+
+void UVRubiksPiecePool::Prewarm(TSubclassOf<AVRubiksPiece> PieceClass, int32 Count)
+{
+	if (!PieceClass) {
+		return;
+	}
+
+	FVRubiksPieceList& List = FreePieces.FindOrAdd(PieceClass.Get());
+	List.Pieces.Reserve(Count);
+	while (List.Pieces.Num() < Count) {
+		AVRubiksPiece* NewPiece = SpawnPiece(PieceClass);
+		if (!NewPiece) {
+			break;
+		}
+		List.Pieces.Add(NewPiece);
+	}
+}
+
+int32 UVRubiksPiecePool::GetNumFreePieces(TSubclassOf<AVRubiksPiece> PieceClass) const
+{
+	const FVRubiksPieceList* List = FreePieces.Find(PieceClass.Get());
+	return List ? List->Pieces.Num() : 0;
+}
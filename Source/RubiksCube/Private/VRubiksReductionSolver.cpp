@@ -0,0 +1,956 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VRubiksReductionSolver.h"
+#include "RubiksCube.h"
+#include "VRubiksFaceletModel.h"
+#include "VRubiksTwoPhaseSolver.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+
+namespace VRubiksReductionSolver
+{
+	static const int8 QuarterTurns[3] = { 1, -1, 2 };
+
+	//Longest sequence of outer turns tried to bring an edge piece in reach of a commutator
+	static constexpr int32 MaxSetupLength = 3;
+
+	//One side of a surface cell: where a single sticker sits
+	struct FSticker
+	{
+		FIntVector Cell;
+		FIntVector Normal;
+	};
+
+	static int32 GetAxis(const FIntVector& Normal)
+	{
+		return Normal.X != 0 ? 0 : (Normal.Y != 0 ? 1 : 2);
+	}
+
+	static int32 GetFace(const FIntVector& Normal)
+	{
+		const int32 Axis = GetAxis(Normal);
+		return FVRubiksFaceletModel::GetFace(Axis, Normal[Axis] > 0);
+	}
+
+	static FIntVector GetNormal(int32 Face)
+	{
+		FIntVector Normal(0);
+		Normal[FVRubiksFaceletModel::GetFaceAxis(Face)] = FVRubiksFaceletModel::IsFacePositive(Face) ? 1 : -1;
+		return Normal;
+	}
+
+	static FIntVector Cross(const FIntVector& A, const FIntVector& B)
+	{
+		return FIntVector(A.Y * B.Z - A.Z * B.Y, A.Z * B.X - A.X * B.Z, A.X * B.Y - A.Y * B.X);
+	}
+
+	//Where Move takes whatever is in Cell, with doubled coordinates around the center like the models
+	static FIntVector MoveCell(const FIntVector& Cell, const FVRubiksMove& Move, int32 Size)
+	{
+		if (Cell[Move.Axis] != Move.Layer) {
+			return Cell;
+		}
+		const FIntVector Offset(Size - 1);
+		return (FVRubiksCubeModel::RotateVector(Cell * 2 - Offset, Move.Axis, Move.QuarterTurns) + Offset) / 2;
+	}
+
+	static FSticker MoveSticker(const FSticker& Sticker, const FVRubiksMove& Move, int32 Size)
+	{
+		if (Sticker.Cell[Move.Axis] != Move.Layer) {
+			return Sticker;
+		}
+		return FSticker { MoveCell(Sticker.Cell, Move, Size), FVRubiksCubeModel::RotateVector(Sticker.Normal, Move.Axis, Move.QuarterTurns) };
+	}
+
+	static FIntVector MoveCell(FIntVector Cell, const TArray<FVRubiksMove>& Moves, int32 Size)
+	{
+		for (const FVRubiksMove& Move : Moves) {
+			Cell = MoveCell(Cell, Move, Size);
+		}
+		return Cell;
+	}
+
+	static void AppendInverse(TArray<FVRubiksMove>& OutMoves, const TArray<FVRubiksMove>& Moves)
+	{
+		for (int32 Index = Moves.Num() - 1; Index >= 0; Index--) {
+			OutMoves.Add(Moves[Index].Inverse());
+		}
+	}
+
+	//Turns on one axis commute, so every run of them is folded into at most one turn per layer
+	static void SimplifyMoves(TArray<FVRubiksMove>& Moves)
+	{
+		TArray<FVRubiksMove> Result;
+		Result.Reserve(Moves.Num());
+		for (const FVRubiksMove& Move : Moves) {
+			int32 Index = Result.Num() - 1;
+			while (Index >= 0 && Result[Index].Axis == Move.Axis && Result[Index].Layer != Move.Layer) {
+				Index--;
+			}
+			if (Index < 0 || Result[Index].Axis != Move.Axis) {
+				Result.Add(Move);
+				continue;
+			}
+
+			const int32 Turns = ((Result[Index].QuarterTurns + Move.QuarterTurns) % 4 + 4) % 4;
+			if (Turns == 0) {
+				Result.RemoveAt(Index);
+			} else {
+				Result[Index].QuarterTurns = (int8)(Turns == 3 ? -1 : Turns);
+			}
+		}
+		Moves = MoveTemp(Result);
+	}
+
+	/**
+	 * Working state of one solve. Every stage appends its moves to Moves and applies them to Cube as it goes.
+	 * Commutators [A, B] = A B A' B' are built so that A and B only share the pieces meant to move (one per line of A),
+	 * which makes each of them a set of independent 3-cycles: the piece at A'(x) goes to x, the one at x to B'(x).
+	 */
+	class FReduction
+	{
+	public:
+		TArray<FVRubiksMove> Moves;
+
+		FReduction(const FVRubiksCubeModel& Model, const FVRubiksReductionSolver::FSettings& InSettings)
+			: Settings(InSettings)
+		{
+			Cube.SetFromModel(Model);
+			Size = Cube.GetSize();
+
+			for (int32 Face1 = 0; Face1 < 6; Face1++) {
+				for (int32 Face2 = Face1 + 1; Face2 < 6; Face2++) {
+					if (FVRubiksFaceletModel::GetFaceAxis(Face1) != FVRubiksFaceletModel::GetFaceAxis(Face2)) {
+						EdgeFaces[NumEdges][0] = Face1;
+						EdgeFaces[NumEdges][1] = Face2;
+						NumEdges++;
+					}
+				}
+			}
+			check(NumEdges == 12);
+
+			ChooseFaceColors();
+		}
+
+		bool SolveCenters()
+		{
+			if (Size < 4) {
+				return true;
+			}
+
+			//Up and down first, then the four faces around them. A finished face is never taken from, the last one is
+			//finished once all the others are
+			static const int32 FaceOrder[6] = { 4, 5, 0, 1, 2, 3 };
+			bool bFinished[6] = {};
+			for (int32 Index = 0; Index < 5; Index++) {
+				const int32 Face = FaceOrder[Index];
+				while (!AreCentersSolved(Face)) {
+					if (IsCancelled()) {
+						return false;
+					}
+
+					TArray<FVRubiksMove> A, B;
+					if (FindCenterCommutator(Face, bFinished, A, B) > 0) {
+						ApplyCommutator(TArray<FVRubiksMove>(), A, B);
+					} else if (!SetUpCenters(Face, bFinished)) {
+						return false;
+					}
+				}
+				bFinished[Face] = true;
+			}
+			return AreCentersSolved(FaceOrder[5]);
+		}
+
+		/**
+		 * A 3-cycle is an even permutation, so each ring of edge pieces (the pieces Ring away from either end of the edges)
+		 * has to be an even permutation of where its pieces belong before pairing. An inner slice turn swaps a ring's
+		 * parity, the centers it breaks are repaired right away. An even cube also needs its corners even, like its edges
+		 * will be once paired, one outer turn fixes that.
+		 */
+		bool FixParity()
+		{
+			if (Size < 4) {
+				return true;
+			}
+
+			FindEdgeTargets();
+			bool bMovedCenters = false;
+			for (int32 Ring = 1; Ring * 2 < Size - 1; Ring++) {
+				bool bOdd = false;
+				if (!GetRingParity(Ring, bOdd)) {
+					return false;
+				}
+				if (bOdd) {
+					Apply(FVRubiksMove(0, Ring, 1));
+					bMovedCenters = true;
+				}
+			}
+			if (bMovedCenters && !SolveCenters()) {
+				return false;
+			}
+
+			bool bCornersOdd = false;
+			if (!GetCornerParity(bCornersOdd)) {
+				return false;
+			}
+			if (bCornersOdd && Size % 2 == 0) {
+				Apply(FVRubiksMove(2, Size - 1, 1));
+			}
+			return true;
+		}
+
+		bool PairEdges()
+		{
+			if (Size < 4) {
+				return true;
+			}
+
+			FindEdgeTargets();
+			bool bFinished[12] = {};
+			for (int32 Edge = 0; Edge < NumEdges; Edge++) {
+				TArray<FIntVector> Wrong;
+				for (GetWrongPieces(Edge, Wrong); Wrong.Num() > 0; GetWrongPieces(Edge, Wrong)) {
+					if (IsCancelled() || !PlaceEdgePieces(Edge, Wrong, bFinished)) {
+						return false;
+					}
+				}
+				bFinished[Edge] = true;
+			}
+			return true;
+		}
+
+		//The reduced cube is read as a 3x3 through its corners, one piece of each edge and one sticker of each center
+		bool SolveThreeByThree()
+		{
+			const int32 Middle = Size % 2 == 1 ? Size / 2 : 1;
+			auto ToCell = [this, Middle](const FIntVector& Cell)
+			{
+				FIntVector Result;
+				for (int32 Axis = 0; Axis < 3; Axis++) {
+					Result[Axis] = Cell[Axis] == 0 ? 0 : (Cell[Axis] == 2 ? Size - 1 : Middle);
+				}
+				return Result;
+			};
+
+			FVRubiksCubieCube Cubies;
+			uint8 Frame = 0;
+			if (!FVRubiksCubieCube::FromStickers([this, &ToCell](const FIntVector& Cell, const FIntVector& Normal)
+				{
+					return GetColor(FSticker { ToCell(Cell), Normal });
+				}, Cubies, Frame)) {
+				return false;
+			}
+
+			//Length hardly matters next to the other stages on big cubes, the first short enough solution will do
+			FVRubiksTwoPhaseSolver::FSettings SolverSettings;
+			SolverSettings.TargetLength = Size == 3 ? SolverSettings.TargetLength : 24;
+			SolverSettings.TimeBudgetSeconds = Settings.TimeBudgetSeconds;
+			SolverSettings.bCancel = Settings.bCancel;
+			TArray<FVRubiksMove> Solution;
+			if (!FVRubiksTwoPhaseSolver::Solve(Cubies, SolverSettings, Solution)) {
+				return false;
+			}
+
+			for (FVRubiksMove Move : Solution) {
+				Move.Layer = Move.Layer == 0 ? 0 : Size - 1;
+				Apply(FVRubiksCubeModel::ReorientMove(Move, Frame, Size));
+			}
+			return Cube.IsSolved();
+		}
+
+	private:
+		const FVRubiksReductionSolver::FSettings& Settings;
+
+		FVRubiksFaceletModel Cube;
+
+		int32 Size;
+
+		//Color each face ends up with
+		uint8 FaceColors[6];
+
+		int32 NumEdges = 0;
+
+		//The two faces of each edge
+		int32 EdgeFaces[12][2];
+
+		//Colors the pieces of each edge must show on its two faces, and the edge for a pair of colors
+		uint8 EdgeColors[12][2];
+		int8 ColorsToEdge[6][6];
+
+		bool IsCancelled() const
+		{
+			return Settings.bCancel && *Settings.bCancel;
+		}
+
+		void Apply(const FVRubiksMove& Move)
+		{
+			Cube.ApplyMove(Move);
+			Moves.Add(Move);
+		}
+
+		void Apply(const TArray<FVRubiksMove>& Sequence)
+		{
+			for (const FVRubiksMove& Move : Sequence) {
+				Apply(Move);
+			}
+		}
+
+		//Setup, A, B, A', B', then the setup undone
+		void ApplyCommutator(const TArray<FVRubiksMove>& Setup, const TArray<FVRubiksMove>& A, const TArray<FVRubiksMove>& B)
+		{
+			TArray<FVRubiksMove> Sequence = Setup;
+			Sequence.Append(A);
+			Sequence.Append(B);
+			AppendInverse(Sequence, A);
+			AppendInverse(Sequence, B);
+			AppendInverse(Sequence, Setup);
+			Apply(Sequence);
+		}
+
+		uint8 GetColor(const FSticker& Sticker) const
+		{
+			const int32 Face = GetFace(Sticker.Normal);
+			int32 ColAxis, RowAxis;
+			FVRubiksFaceletModel::GetFaceAxes(Face, ColAxis, RowAxis);
+			return Cube.GetSticker(Face, Sticker.Cell[ColAxis], Sticker.Cell[RowAxis]);
+		}
+
+		FSticker GetCenter(int32 Face, int32 LineAxis, int32 Line, int32 Index) const
+		{
+			const int32 FaceAxis = FVRubiksFaceletModel::GetFaceAxis(Face);
+			FSticker Sticker { FIntVector(0), GetNormal(Face) };
+			Sticker.Cell[FaceAxis] = FVRubiksFaceletModel::IsFacePositive(Face) ? Size - 1 : 0;
+			Sticker.Cell[LineAxis] = Line;
+			Sticker.Cell[3 - FaceAxis - LineAxis] = Index;
+			return Sticker;
+		}
+
+		/**
+		 * Odd cubes keep their middle centers, they give the colors. Even cubes take the orientation of the color scheme
+		 * that already has the most centers in place.
+		 */
+		void ChooseFaceColors()
+		{
+			if (Size % 2 == 1) {
+				for (int32 Face = 0; Face < 6; Face++) {
+					const int32 LineAxis = (FVRubiksFaceletModel::GetFaceAxis(Face) + 1) % 3;
+					FaceColors[Face] = GetColor(GetCenter(Face, LineAxis, Size / 2, Size / 2));
+				}
+				return;
+			}
+
+			int32 BestMatches = -1;
+			for (int32 Orientation = 0; Orientation < FVRubiksCubeModel::NumOrientations(); Orientation++) {
+				uint8 Colors[6];
+				for (int32 Color = 0; Color < 6; Color++) {
+					Colors[GetFace(FVRubiksCubeModel::RotateByOrientation((uint8)Orientation, GetNormal(Color)))] = (uint8)Color;
+				}
+
+				int32 Matches = 0;
+				for (int32 Face = 0; Face < 6; Face++) {
+					const int32 LineAxis = (FVRubiksFaceletModel::GetFaceAxis(Face) + 1) % 3;
+					for (int32 Line = 1; Line < Size - 1; Line++) {
+						for (int32 Index = 1; Index < Size - 1; Index++) {
+							Matches += GetColor(GetCenter(Face, LineAxis, Line, Index)) == Colors[Face];
+						}
+					}
+				}
+				if (Matches > BestMatches) {
+					BestMatches = Matches;
+					FMemory::Memcpy(FaceColors, Colors, sizeof(Colors));
+				}
+			}
+		}
+
+		bool AreCentersSolved(int32 Face) const
+		{
+			const int32 LineAxis = (FVRubiksFaceletModel::GetFaceAxis(Face) + 1) % 3;
+			for (int32 Line = 1; Line < Size - 1; Line++) {
+				for (int32 Index = 1; Index < Size - 1; Index++) {
+					if (GetColor(GetCenter(Face, LineAxis, Line, Index)) != FaceColors[Face]) {
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		/**
+		 * A is an inner slice through a line of Face, B turns Face, turns parallel inner slices and turns Face back, so
+		 * each of B's slices crosses A's line at one wrong center. The centers come from the face A turns onto Face and
+		 * the displaced ones go where B's slices take them, neither may be a finished face. Returns how many centers the
+		 * best such commutator places.
+		 */
+		int32 FindCenterCommutator(int32 Face, const bool bFinished[6], TArray<FVRubiksMove>& OutA, TArray<FVRubiksMove>& OutB) const
+		{
+			const int32 FaceAxis = FVRubiksFaceletModel::GetFaceAxis(Face);
+			const int32 FaceLayer = FVRubiksFaceletModel::IsFacePositive(Face) ? Size - 1 : 0;
+			const uint8 Color = FaceColors[Face];
+
+			int32 BestCount = 0;
+			TArray<FSticker, TInlineAllocator<16>> Wrong;
+			TArray<int32, TInlineAllocator<16>> CrossLayers;
+			for (int32 LineAxis = 0; LineAxis < 3; LineAxis++) {
+				if (LineAxis == FaceAxis) {
+					continue;
+				}
+
+				for (int32 Line = 1; Line < Size - 1; Line++) {
+					Wrong.Reset();
+					for (int32 Index = 1; Index < Size - 1; Index++) {
+						const FSticker Center = GetCenter(Face, LineAxis, Line, Index);
+						if (GetColor(Center) != Color) {
+							Wrong.Add(Center);
+						}
+					}
+					if (Wrong.Num() <= BestCount) {
+						continue;
+					}
+
+					for (int8 LineTurns : QuarterTurns) {
+						const FVRubiksMove LineMove(LineAxis, Line, LineTurns);
+						for (int32 FaceTurns = -1; FaceTurns <= 1; FaceTurns += 2) {
+							const FVRubiksMove FaceMove(FaceAxis, FaceLayer, FaceTurns);
+							for (int8 CrossTurns : QuarterTurns) {
+								CrossLayers.Reset();
+								for (const FSticker& Target : Wrong) {
+									const FSticker Turned = MoveSticker(Target, FaceMove, Size);
+									const int32 CrossLayer = Turned.Cell[LineAxis];
+									if (CrossLayer == Line) {
+										continue;
+									}
+
+									const FSticker Source = MoveSticker(Target, LineMove.Inverse(), Size);
+									if (bFinished[GetFace(Source.Normal)] || GetColor(Source) != Color) {
+										continue;
+									}
+
+									const FSticker Displaced = MoveSticker(Turned, FVRubiksMove(LineAxis, CrossLayer, -CrossTurns), Size);
+									if (!bFinished[GetFace(Displaced.Normal)]) {
+										CrossLayers.Add(CrossLayer);
+									}
+								}
+
+								if (CrossLayers.Num() > BestCount) {
+									BestCount = CrossLayers.Num();
+									OutA.Reset();
+									OutA.Add(LineMove);
+									OutB.Reset();
+									OutB.Add(FaceMove);
+									for (int32 CrossLayer : CrossLayers) {
+										OutB.Add(FVRubiksMove(LineAxis, CrossLayer, CrossTurns));
+									}
+									OutB.Add(FaceMove.Inverse());
+								}
+							}
+						}
+					}
+				}
+			}
+			return BestCount;
+		}
+
+		//Turns the unfinished face that brings the most of Face's color in reach of a commutator. Only edges and
+		//the turned face's own centers move, all free at this point
+		bool SetUpCenters(int32 Face, const bool bFinished[6])
+		{
+			int32 BestCount = 0;
+			FVRubiksMove BestMove;
+			TArray<FVRubiksMove> A, B;
+			for (int32 Other = 0; Other < 6; Other++) {
+				if (Other == Face || bFinished[Other]) {
+					continue;
+				}
+
+				for (int8 Turns : QuarterTurns) {
+					const FVRubiksMove Move(FVRubiksFaceletModel::GetFaceAxis(Other), FVRubiksFaceletModel::IsFacePositive(Other) ? Size - 1 : 0, Turns);
+					Cube.ApplyMove(Move);
+					const int32 Count = FindCenterCommutator(Face, bFinished, A, B);
+					Cube.ApplyMove(Move.Inverse());
+					if (Count > BestCount) {
+						BestCount = Count;
+						BestMove = Move;
+					}
+				}
+			}
+
+			if (BestCount == 0) {
+				return false;
+			}
+			Apply(BestMove);
+			return true;
+		}
+
+		//Up to three cells of the surface with coordinates on the cube's faces, one sticker each
+		int32 GetCellStickers(const FIntVector& Cell, FSticker OutStickers[3]) const
+		{
+			int32 NumStickers = 0;
+			for (int32 Axis = 0; Axis < 3; Axis++) {
+				if (Cell[Axis] == 0 || Cell[Axis] == Size - 1) {
+					FIntVector Normal(0);
+					Normal[Axis] = Cell[Axis] == 0 ? -1 : 1;
+					OutStickers[NumStickers++] = FSticker { Cell, Normal };
+				}
+			}
+			return NumStickers;
+		}
+
+		//Cell of the edge's piece at Along, measured from the end its two face normals turn towards
+		FIntVector GetEdgeCell(int32 Edge, int32 Along) const
+		{
+			const FIntVector Normal1 = GetNormal(EdgeFaces[Edge][0]);
+			const FIntVector Normal2 = GetNormal(EdgeFaces[Edge][1]);
+			const FIntVector Direction = Cross(Normal1, Normal2);
+			const int32 Axis = GetAxis(Direction);
+
+			FIntVector Cell;
+			Cell[GetAxis(Normal1)] = Normal1[GetAxis(Normal1)] > 0 ? Size - 1 : 0;
+			Cell[GetAxis(Normal2)] = Normal2[GetAxis(Normal2)] > 0 ? Size - 1 : 0;
+			Cell[Axis] = Direction[Axis] > 0 ? Along : Size - 1 - Along;
+			return Cell;
+		}
+
+		//How far along its edge Cell is, the inverse of GetEdgeCell
+		int32 GetEdgeAlong(const FIntVector& Cell) const
+		{
+			const int32 Edge = GetEdge(Cell);
+			const FIntVector Direction = Cross(GetNormal(EdgeFaces[Edge][0]), GetNormal(EdgeFaces[Edge][1]));
+			const int32 Axis = GetAxis(Direction);
+			return Direction[Axis] > 0 ? Cell[Axis] : Size - 1 - Cell[Axis];
+		}
+
+		int32 GetEdge(const FIntVector& Cell) const
+		{
+			FSticker Stickers[3];
+			verify(GetCellStickers(Cell, Stickers) == 2);
+			const int32 Face1 = GetFace(Stickers[0].Normal);
+			const int32 Face2 = GetFace(Stickers[1].Normal);
+			for (int32 Edge = 0; Edge < NumEdges; Edge++) {
+				if ((EdgeFaces[Edge][0] == Face1 && EdgeFaces[Edge][1] == Face2) || (EdgeFaces[Edge][0] == Face2 && EdgeFaces[Edge][1] == Face1)) {
+					return Edge;
+				}
+			}
+			return INDEX_NONE;
+		}
+
+		//Edges pair up around the middle pieces on odd cubes, even cubes put them straight where the centers say
+		void FindEdgeTargets()
+		{
+			FMemory::Memset(ColorsToEdge, INDEX_NONE, sizeof(ColorsToEdge));
+			for (int32 Edge = 0; Edge < NumEdges; Edge++) {
+				if (Size % 2 == 1) {
+					const FIntVector Cell = GetEdgeCell(Edge, Size / 2);
+					EdgeColors[Edge][0] = GetColor(FSticker { Cell, GetNormal(EdgeFaces[Edge][0]) });
+					EdgeColors[Edge][1] = GetColor(FSticker { Cell, GetNormal(EdgeFaces[Edge][1]) });
+				} else {
+					EdgeColors[Edge][0] = FaceColors[EdgeFaces[Edge][0]];
+					EdgeColors[Edge][1] = FaceColors[EdgeFaces[Edge][1]];
+				}
+				ColorsToEdge[EdgeColors[Edge][0]][EdgeColors[Edge][1]] = (int8)Edge;
+				ColorsToEdge[EdgeColors[Edge][1]][EdgeColors[Edge][0]] = (int8)Edge;
+			}
+		}
+
+		/**
+		 * Cell the edge piece now in Cell belongs in. Its colors give the edge, and how far along it sits, measured
+		 * towards the cross product of its two stickers' normals, never changes: edge pieces cannot flip in place.
+		 */
+		bool GetEdgeTarget(const FIntVector& Cell, FIntVector& OutCell) const
+		{
+			FSticker Stickers[3];
+			if (GetCellStickers(Cell, Stickers) != 2) {
+				return false;
+			}
+			const uint8 Color1 = GetColor(Stickers[0]);
+			const uint8 Color2 = GetColor(Stickers[1]);
+			const int32 Edge = ColorsToEdge[Color1][Color2];
+			if (Edge == INDEX_NONE) {
+				return false;
+			}
+
+			const FIntVector Direction = Cross(Stickers[0].Normal, Stickers[1].Normal);
+			const int32 Axis = GetAxis(Direction);
+			const int32 Along = Direction[Axis] > 0 ? Cell[Axis] : Size - 1 - Cell[Axis];
+
+			//The edge's cells are numbered along its faces in order, swapped when the first color belongs on the second face
+			OutCell = GetEdgeCell(Edge, EdgeColors[Edge][0] == Color1 ? Along : Size - 1 - Along);
+			return true;
+		}
+
+		bool IsEdgePieceSolved(const FIntVector& Cell) const
+		{
+			FIntVector Target;
+			return GetEdgeTarget(Cell, Target) && Target == Cell;
+		}
+
+		//Edge pieces of the edge not where they belong, middle pieces of odd cubes excluded
+		void GetWrongPieces(int32 Edge, TArray<FIntVector>& OutCells) const
+		{
+			OutCells.Reset();
+			for (int32 Along = 1; Along < Size - 1; Along++) {
+				const FIntVector Cell = GetEdgeCell(Edge, Along);
+				if (Along * 2 != Size - 1 && !IsEdgePieceSolved(Cell)) {
+					OutCells.Add(Cell);
+				}
+			}
+		}
+
+		bool GetRingParity(int32 Ring, bool& bOutOdd) const
+		{
+			TArray<FIntVector> Cells;
+			for (int32 Edge = 0; Edge < NumEdges; Edge++) {
+				Cells.Add(GetEdgeCell(Edge, Ring));
+				Cells.Add(GetEdgeCell(Edge, Size - 1 - Ring));
+			}
+
+			TArray<int32> Permutation;
+			TArray<bool> bSeen;
+			bSeen.Init(false, Cells.Num());
+			for (const FIntVector& Cell : Cells) {
+				FIntVector Target;
+				const int32 Index = GetEdgeTarget(Cell, Target) ? Cells.IndexOfByKey(Target) : INDEX_NONE;
+				if (Index == INDEX_NONE || bSeen[Index]) {
+					return false;
+				}
+				bSeen[Index] = true;
+				Permutation.Add(Index);
+			}
+			bOutOdd = GetParity(Permutation);
+			return true;
+		}
+
+		bool GetCornerParity(bool& bOutOdd) const
+		{
+			TArray<int32> Permutation;
+			uint8 bSeen = 0;
+			for (int32 Corner = 0; Corner < 8; Corner++) {
+				const FIntVector Cell((Corner & 1) * (Size - 1), ((Corner >> 1) & 1) * (Size - 1), (Corner >> 2) * (Size - 1));
+				FSticker Stickers[3];
+				GetCellStickers(Cell, Stickers);
+
+				//Each color belongs on the face showing it in the middle
+				int32 Target = 0;
+				for (const FSticker& Sticker : Stickers) {
+					int32 Face = 0;
+					while (Face < 6 && FaceColors[Face] != GetColor(Sticker)) {
+						Face++;
+					}
+					if (Face == 6) {
+						return false;
+					}
+					Target |= FVRubiksFaceletModel::IsFacePositive(Face) << FVRubiksFaceletModel::GetFaceAxis(Face);
+				}
+				if (bSeen & (1 << Target)) {
+					return false;
+				}
+				bSeen |= 1 << Target;
+				Permutation.Add(Target);
+			}
+			bOutOdd = GetParity(Permutation);
+			return true;
+		}
+
+		static bool GetParity(const TArray<int32>& Permutation)
+		{
+			bool bOdd = false;
+			TArray<bool> bVisited;
+			bVisited.Init(false, Permutation.Num());
+			for (int32 Start = 0; Start < Permutation.Num(); Start++) {
+				for (int32 Index = Permutation[Start]; !bVisited[Start] && Index != Start; Index = Permutation[Index]) {
+					bOdd = !bOdd;
+				}
+				for (int32 Index = Start; !bVisited[Index]; Index = Permutation[Index]) {
+					bVisited[Index] = true;
+				}
+			}
+			return bOdd;
+		}
+
+		/**
+		 * Commutators of A, inner slices through pieces of one edge, and B, a turn of an outer layer parallel to them
+		 * conjugated by a turn of one of the edge's faces, so B carries a piece of that layer through the whole edge.
+		 * A only moves centers B leaves alone, so only edge pieces move. Setup turns bring the edge and the pieces it
+		 * needs in line first and are undone after, so everything finished stays where it is. Shortest setups first,
+		 * then the commutator placing the most pieces.
+		 */
+		bool PlaceEdgePieces(int32 Edge, const TArray<FIntVector>& Wrong, const bool bFinished[12])
+		{
+			//Where the piece each wrong cell needs is now, searched among the cells it can reach
+			TArray<FIntVector> Sources;
+			for (const FIntVector& Target : Wrong) {
+				const int32 Along = GetEdgeAlong(Target);
+				FIntVector Source;
+				bool bFound = false;
+				for (int32 Other = 0; Other < NumEdges && !bFound; Other++) {
+					for (int32 End = 0; End < 2 && !bFound; End++) {
+						Source = GetEdgeCell(Other, End == 0 ? Along : Size - 1 - Along);
+						FIntVector SourceTarget;
+						bFound = GetEdgeTarget(Source, SourceTarget) && SourceTarget == Target;
+					}
+				}
+				if (!bFound) {
+					return false;
+				}
+				Sources.Add(Source);
+			}
+
+			auto IsLocked = [this, Edge, bFinished](const FIntVector& Cell)
+			{
+				const int32 CellEdge = GetEdge(Cell);
+				return (CellEdge == Edge || bFinished[CellEdge]) && IsEdgePieceSolved(Cell);
+			};
+
+			int32 BestCount = 0;
+			TArray<FVRubiksMove> BestSetup, BestA, BestB;
+			TArray<FVRubiksMove> A, Undo;
+
+			//Cells and Sources as the setup left them
+			auto TrySetup = [&](const TArray<FVRubiksMove>& Setup, const TArray<FIntVector>& Cells, const TArray<FIntVector>& SetupSources)
+			{
+				//The edge where the setup puts the first wrong piece, its axis and its two faces
+				const FIntVector& First = Cells[0];
+				FSticker Stickers[3];
+				GetCellStickers(First, Stickers);
+				const int32 EdgeAxis = 3 - GetAxis(Stickers[0].Normal) - GetAxis(Stickers[1].Normal);
+
+				//A turns each source onto its cell, which also fixes the turn of its slice
+				TArray<int8, TInlineAllocator<16>> SliceTurns;
+				SliceTurns.SetNumZeroed(Cells.Num());
+				int32 NumCandidates = 0;
+				for (int32 Index = 0; Index < Cells.Num(); Index++) {
+					const FIntVector& Cell = Cells[Index];
+					if (Cell[(EdgeAxis + 1) % 3] != First[(EdgeAxis + 1) % 3] || Cell[(EdgeAxis + 2) % 3] != First[(EdgeAxis + 2) % 3]) {
+						continue;
+					}
+					for (int8 Turns : QuarterTurns) {
+						if (MoveCell(SetupSources[Index], FVRubiksMove(EdgeAxis, Cell[EdgeAxis], Turns), Size) == Cell) {
+							SliceTurns[Index] = Turns;
+							NumCandidates++;
+						}
+					}
+				}
+				if (NumCandidates <= BestCount) {
+					return;
+				}
+
+				bool bUndoReady = false;
+				for (int8 Turns : QuarterTurns) {
+					for (int32 SideIndex = 0; SideIndex < 2; SideIndex++) {
+						const FIntVector& Normal = Stickers[SideIndex].Normal;
+						const FVRubiksMove SideMove(GetAxis(Normal), Normal[GetAxis(Normal)] > 0 ? Size - 1 : 0, 1);
+						for (int32 OuterLayer = 0; OuterLayer < Size; OuterLayer += Size - 1) {
+							//The side turn that brings the outer layer's edge onto this one
+							const FVRubiksMove SideTurn(SideMove.Axis, SideMove.Layer, MoveCell(First, SideMove, Size)[EdgeAxis] == OuterLayer ? 1 : -1);
+							for (int8 OuterTurns : QuarterTurns) {
+								const FVRubiksMove OuterMove(EdgeAxis, OuterLayer, OuterTurns);
+								A.Reset();
+								for (int32 Index = 0; Index < Cells.Num(); Index++) {
+									if (SliceTurns[Index] != Turns) {
+										continue;
+									}
+									if (!bUndoReady) {
+										Undo.Reset();
+										AppendInverse(Undo, Setup);
+										bUndoReady = true;
+									}
+
+									FIntVector Displaced = MoveCell(MoveCell(Cells[Index], SideTurn, Size), OuterMove.Inverse(), Size);
+									Displaced = MoveCell(MoveCell(Displaced, SideTurn.Inverse(), Size), Undo, Size);
+									if (!IsLocked(Displaced)) {
+										A.Add(FVRubiksMove(EdgeAxis, Cells[Index][EdgeAxis], Turns));
+									}
+								}
+
+								if (A.Num() > BestCount) {
+									BestCount = A.Num();
+									BestSetup = Setup;
+									BestA = A;
+									BestB.Reset();
+									BestB.Add(SideTurn);
+									BestB.Add(OuterMove);
+									BestB.Add(SideTurn.Inverse());
+								}
+							}
+						}
+					}
+				}
+			};
+
+			TArray<FVRubiksMove> OuterMoves;
+			for (int32 Face = 0; Face < 6; Face++) {
+				for (int8 Turns : QuarterTurns) {
+					OuterMoves.Add(FVRubiksMove(FVRubiksFaceletModel::GetFaceAxis(Face), FVRubiksFaceletModel::IsFacePositive(Face) ? Size - 1 : 0, Turns));
+				}
+			}
+
+			//Depth first over setups of outer turns, the cells moved along one turn at a time
+			TArray<FVRubiksMove> Setup;
+			TArray<TArray<FIntVector>> Cells, SetupSources;
+			Cells.Add(Wrong);
+			SetupSources.Add(Sources);
+			TFunction<void(int32)> Search = [&](int32 Remaining)
+			{
+				const int32 Depth = Setup.Num();
+				if (Remaining == 0) {
+					TrySetup(Setup, Cells[Depth], SetupSources[Depth]);
+					return;
+				}
+				if (Cells.Num() <= Depth + 1) {
+					Cells.AddDefaulted();
+					SetupSources.AddDefaulted();
+				}
+				for (const FVRubiksMove& Move : OuterMoves) {
+					if (Depth > 0 && Setup.Last().Axis == Move.Axis && Setup.Last().Layer == Move.Layer) {
+						continue;
+					}
+					Cells[Depth + 1].Reset();
+					SetupSources[Depth + 1].Reset();
+					for (int32 Index = 0; Index < Wrong.Num(); Index++) {
+						Cells[Depth + 1].Add(MoveCell(Cells[Depth][Index], Move, Size));
+						SetupSources[Depth + 1].Add(MoveCell(SetupSources[Depth][Index], Move, Size));
+					}
+					Setup.Add(Move);
+					Search(Remaining - 1);
+					Setup.Pop();
+				}
+			};
+			for (int32 Length = 0; Length <= MaxSetupLength && BestCount == 0; Length++) {
+				Search(Length);
+			}
+
+			//Once only two edges are left, the three pieces of a cycle cannot sit on three different edges. An inner slice in
+			//the setup moves some pieces of an edge and not the others, so two edges can stand in for three
+			TArray<FIntVector> SliceCells, SliceSources;
+			for (int32 Before = -1; Before < OuterMoves.Num() && BestCount == 0; Before++) {
+				for (int32 Axis = 0; Axis < 3; Axis++) {
+					for (int32 Layer = 1; Layer < Size - 1; Layer++) {
+						for (int8 Turns : QuarterTurns) {
+							Setup.Reset();
+							if (Before >= 0) {
+								Setup.Add(OuterMoves[Before]);
+							}
+							Setup.Add(FVRubiksMove(Axis, Layer, Turns));
+							for (int32 After = -1; After < OuterMoves.Num(); After++) {
+								if (After >= 0) {
+									Setup.Add(OuterMoves[After]);
+								}
+								SliceCells.Reset();
+								SliceSources.Reset();
+								for (int32 Index = 0; Index < Wrong.Num(); Index++) {
+									SliceCells.Add(MoveCell(Wrong[Index], Setup, Size));
+									SliceSources.Add(MoveCell(Sources[Index], Setup, Size));
+								}
+								TrySetup(Setup, SliceCells, SliceSources);
+								if (After >= 0) {
+									Setup.Pop();
+								}
+							}
+						}
+					}
+				}
+			}
+
+			if (BestCount == 0) {
+				return false;
+			}
+			ApplyCommutator(BestSetup, BestA, BestB);
+			return true;
+		}
+	};
+
+	//Seeded scrambles of every size in range, each solution checked on a piece model
+	static void RunBenchmark(const TArray<FString>& Args)
+	{
+		const int32 MinSize = Args.Num() > 0 ? FMath::Clamp(FCString::Atoi(*Args[0]), 3, 16) : 3;
+		const int32 MaxSize = Args.Num() > 1 ? FMath::Clamp(FCString::Atoi(*Args[1]), MinSize, 16) : 16;
+		const int32 NumPositions = Args.Num() > 2 ? FMath::Max(FCString::Atoi(*Args[2]), 1) : 10;
+
+		FVRubiksTwoPhaseSolver::BuildTables();
+
+		FRandomStream Random(0x52424B52);
+		for (int32 Size = MinSize; Size <= MaxSize; Size++) {
+			double TotalSeconds = 0.0;
+			double MaxSeconds = 0.0;
+			int64 TotalLength = 0;
+			int32 MaxLength = 0;
+			int32 NumFailed = 0;
+			for (int32 Position = 0; Position < NumPositions; Position++) {
+				FVRubiksCubeModel Model;
+				Model.Reset(Size);
+				for (int32 Step = 0; Step < Size * 20; Step++) {
+					Model.ApplyMove(FVRubiksMove(Random.RandHelper(3), Random.RandHelper(Size), QuarterTurns[Random.RandHelper(3)]));
+				}
+
+				TArray<FVRubiksMove> Solution;
+				const double StartTime = FPlatformTime::Seconds();
+				const bool bSolved = FVRubiksReductionSolver::SolveModel(Model, FVRubiksReductionSolver::FSettings(), Solution);
+				const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+				for (const FVRubiksMove& Move : Solution) {
+					Model.ApplyMove(Move);
+				}
+				if (!bSolved || !Model.IsSolved()) {
+					NumFailed++;
+					continue;
+				}
+
+				TotalSeconds += Seconds;
+				MaxSeconds = FMath::Max(MaxSeconds, Seconds);
+				TotalLength += Solution.Num();
+				MaxLength = FMath::Max(MaxLength, Solution.Num());
+			}
+
+			const int32 NumSolved = FMath::Max(NumPositions - NumFailed, 1);
+			UE_LOG(LogRubiks, Display, TEXT("Reduction solver %dx%d: %d positions, %d failed, %.1f ms average, %.1f ms max, %.0f moves average, %d max"),
+				Size, Size, NumPositions, NumFailed, TotalSeconds * 1000.0 / NumSolved, MaxSeconds * 1000.0, (double)TotalLength / NumSolved, MaxLength);
+		}
+	}
+
+	static FAutoConsoleCommand BenchmarkCommand(
+		TEXT("Rubiks.ReductionBenchmark"),
+		TEXT("Solves seeded scrambles of each size with the reduction solver and logs time and move count. Usage: Rubiks.ReductionBenchmark [MinSize=3] [MaxSize=16] [Positions=10]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&RunBenchmark));
+}
+
+bool FVRubiksReductionSolver::SolveModel(const FVRubiksCubeModel& Model, const FSettings& Settings, TArray<FVRubiksMove>& OutMoves)
+{
+	using namespace VRubiksReductionSolver;
+
+	OutMoves.Reset();
+	if (Model.GetSize() < 3) {
+		return false;
+	}
+
+	struct FStage
+	{
+		const TCHAR* Name;
+		bool (FReduction::*Run)();
+	};
+	static const FStage Stages[] = {
+		{ TEXT("centers"), &FReduction::SolveCenters },
+		{ TEXT("parity"), &FReduction::FixParity },
+		{ TEXT("edges"), &FReduction::PairEdges },
+		{ TEXT("3x3"), &FReduction::SolveThreeByThree }
+	};
+
+	FReduction Reduction(Model, Settings);
+	for (const FStage& Stage : Stages) {
+		const double StartTime = FPlatformTime::Seconds();
+		Reduction.Moves.Reset();
+		if (!(Reduction.*Stage.Run)()) {
+			UE_LOG(LogRubiks, Verbose, TEXT("Reduction solver %dx%d: %s stage failed"), Model.GetSize(), Model.GetSize(), Stage.Name);
+			return false;
+		}
+
+		SimplifyMoves(Reduction.Moves);
+		UE_LOG(LogRubiks, Verbose, TEXT("Reduction solver %dx%d: %s stage, %d moves in %.1f ms"),
+			Model.GetSize(), Model.GetSize(), Stage.Name, Reduction.Moves.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+		OutMoves.Append(Reduction.Moves);
+		if (Settings.OnStageSolved && Reduction.Moves.Num() > 0) {
+			Settings.OnStageSolved(Reduction.Moves);
+		}
+	}
+	return true;
+}
@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VRubiksSaveGame.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace VRubiksSaveGame
+{
+	static constexpr uint32 Magic = 0x53534252; //RBSS
+	static constexpr uint16 Version = 1;
+}
+
+void UVRubiksSaveGame::Store(const FVRubiksCubeModel& Model, int32 Steps, float ElapsedTime, const TArray<FVRubiksMove>& History)
+{
+	Data.Reset();
+	FMemoryWriter Writer(Data);
+
+	//Header, timer and steps, then the packed model and the packed history
+	uint32 SaveMagic = VRubiksSaveGame::Magic;
+	uint16 SaveVersion = VRubiksSaveGame::Version;
+	Writer << SaveMagic << SaveVersion << Steps << ElapsedTime;
+	Model.Save(Writer);
+
+	int32 NumMoves = History.Num();
+	Writer << NumMoves;
+	for (const FVRubiksMove& Move : History) {
+		uint16 Packed = Move.Pack();
+		Writer << Packed;
+	}
+}
+
+bool UVRubiksSaveGame::Restore(FVRubiksCubeModel& OutModel, int32& OutSteps, float& OutElapsedTime, TArray<FVRubiksMove>& OutHistory) const
+{
+	FMemoryReader Reader(Data);
+
+	uint32 SaveMagic = 0;
+	uint16 SaveVersion = 0;
+	int32 Steps = 0;
+	float ElapsedTime = 0.0f;
+	Reader << SaveMagic << SaveVersion << Steps << ElapsedTime;
+	if (Reader.IsError() || SaveMagic != VRubiksSaveGame::Magic || SaveVersion != VRubiksSaveGame::Version) {
+		return false;
+	}
+
+	FVRubiksCubeModel Model;
+	if (!Model.Load(Reader)) {
+		return false;
+	}
+
+	int32 NumMoves = 0;
+	Reader << NumMoves;
+	if (Reader.IsError() || NumMoves < 0 || NumMoves * (int64)sizeof(uint16) > Reader.TotalSize() - Reader.Tell()) {
+		return false;
+	}
+
+	TArray<FVRubiksMove> History;
+	History.SetNumUninitialized(NumMoves);
+	for (FVRubiksMove& Move : History) {
+		uint16 Packed = 0;
+		Reader << Packed;
+		if (!FVRubiksMove::Unpack(Packed, Move) || !Model.IsValidMove(Move)) {
+			return false;
+		}
+	}
+
+	OutModel = MoveTemp(Model);
+	OutSteps = Steps;
+	OutElapsedTime = ElapsedTime;
+	OutHistory = MoveTemp(History);
+	return true;
+}
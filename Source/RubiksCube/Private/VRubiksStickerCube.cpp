@@ -0,0 +1,340 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VRubiksStickerCube.h"
+#include "VRubiksColorScheme.h"
+#include "VRubiksFaceTexture.h"
+#include "FCTween.h"
+#include "ProceduralMeshComponent.h"
+#include "Engine/Texture2D.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+namespace VRubiksStickerCube
+{
+	//Gap between band stickers and how far they float over the faces, in sticker widths
+	static constexpr float BandGap = 0.05f;
+	static constexpr float BandLift = 0.02f;
+}
+
+// Sets default values
+AVRubiksStickerCube::AVRubiksStickerCube()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	Size = 64;
+	StickerWidth = 10.0f;
+	FaceMaterial = nullptr;
+	BandMaterial = nullptr;
+	bIsAnimating = false;
+	Steps = 0;
+	ActiveTween = nullptr;
+	FaceColors = UVRubiksColorSchemeLibrary::GetSchemeColors(EVRubiksColorScheme::Standard);
+
+	DummySceneComponent = CreateDefaultSubobject<USceneComponent>(FName("Dummy Root"));
+	SetRootComponent(DummySceneComponent);
+
+	RotatorSceneComponent = CreateDefaultSubobject<USceneComponent>(FName("Band Rotator"));
+	RotatorSceneComponent->SetupAttachment(GetRootComponent());
+
+	for (int32 Face = 0; Face < 6; Face++) {
+		UProceduralMeshComponent* FaceComponent = CreateDefaultSubobject<UProceduralMeshComponent>(*FString::Printf(TEXT("Face %d"), Face));
+		FaceComponent->SetupAttachment(GetRootComponent());
+		FaceComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		FaceComponents.Add(FaceComponent);
+	}
+
+	BandComponent = CreateDefaultSubobject<UProceduralMeshComponent>(FName("Band"));
+	BandComponent->SetupAttachment(RotatorSceneComponent);
+	BandComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+}
+
+void AVRubiksStickerCube::BeginPlay()
+{
+	Super::BeginPlay();
+	Build();
+}
+
+void AVRubiksStickerCube::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (ActiveTween) {
+		ActiveTween->Destroy();
+		ActiveTween = nullptr;
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void AVRubiksStickerCube::SetSize(int32 NewSize)
+{
+	//Layers are packed on 11 bits in a move
+	Size = FMath::Clamp(NewSize, 2, 1024);
+	Build();
+}
+
+int32 AVRubiksStickerCube::GetSize()
+{
+	return Size;
+}
+
+FVector AVRubiksStickerCube::GetCenter() const
+{
+	//Sticker cells are centered on multiples of the width, like the pieces of AVRubiksCube
+	return FVector(StickerWidth * (Size - 1) / 2);
+}
+
+void AVRubiksStickerCube::Build()
+{
+	if (ActiveTween) {
+		ActiveTween->Destroy();
+		ActiveTween = nullptr;
+	}
+	bIsAnimating = false;
+	Steps = 0;
+
+	Model.Reset(Size);
+	Palette.SetNumUninitialized(6);
+	for (int32 Face = 0; Face < 6; Face++) {
+		Palette[Face] = FaceColors.IsValidIndex(Face) ? FaceColors[Face].ToFColor(true) : FColor::Black;
+	}
+
+	RotatorSceneComponent->SetRelativeLocation(GetCenter());
+	RotatorSceneComponent->SetRelativeRotation(FRotator(0, 0, 0));
+	BandComponent->ClearAllMeshSections();
+
+	FaceTextures.SetNum(6);
+	FaceMaterialInstances.SetNum(6);
+	for (int32 Face = 0; Face < 6; Face++) {
+		CreateFace(Face);
+	}
+	OnCubeChanged.Broadcast(Steps);
+}
+
+void AVRubiksStickerCube::CreateFace(int32 Face)
+{
+	UProceduralMeshComponent* FaceComponent = FaceComponents[Face];
+	FaceComponent->AttachToComponent(GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+	FaceComponent->SetRelativeTransform(FTransform::Identity);
+
+	TArray<FVector> Vertices;
+	TArray<int32> Triangles;
+	TArray<FVector> Normals;
+	TArray<FVector2D> UVs;
+	TArray<FColor> Colors;
+	FVector Corners[4];
+	GetFaceCorners(Face, 0, Size, 0, Size, 0.0f, Corners);
+	AddQuad(Face, Corners, FColor::White, Vertices, Triangles, Normals, UVs, Colors);
+	FaceComponent->CreateMeshSection(0, Vertices, Triangles, Normals, UVs, Colors, TArray<FProcMeshTangent>(), false);
+
+	//Only recreate the texture when the size changed, its content is fully uploaded below anyway
+	UTexture2D*& Texture = FaceTextures[Face];
+	if (!Texture || Texture->GetSizeX() != Size) {
+		Texture = FVRubiksFaceTexture::Create(Size);
+	}
+
+	UMaterialInstanceDynamic*& MaterialInstance = FaceMaterialInstances[Face];
+	if (!MaterialInstance || MaterialInstance->Parent != FaceMaterial) {
+		MaterialInstance = UMaterialInstanceDynamic::Create(FaceMaterial, this);
+	}
+	MaterialInstance->SetTextureParameterValue(FName("Stickers"), Texture);
+	FaceComponent->SetMaterial(0, MaterialInstance);
+
+	UploadFaceRect(Face, FIntRect(0, 0, Size, Size));
+	UpdateFaceRotation(Face);
+	SetHiddenRect(Face, FIntRect());
+}
+
+void AVRubiksStickerCube::GetFaceCorners(int32 Face, float ColStart, float ColEnd, float RowStart, float RowEnd, float Lift, FVector (&OutCorners)[4]) const
+{
+	int32 ColAxis, RowAxis;
+	FVRubiksFaceletModel::GetFaceAxes(Face, ColAxis, RowAxis);
+	const int32 FaceAxis = FVRubiksFaceletModel::GetFaceAxis(Face);
+
+	//Cells span half a width around their center
+	const float HalfWidth = StickerWidth / 2;
+	const float Plane = FVRubiksFaceletModel::IsFacePositive(Face) ? Size * StickerWidth - HalfWidth + Lift : -HalfWidth - Lift;
+	const float Cols[4] = { ColStart, ColEnd, ColEnd, ColStart };
+	const float Rows[4] = { RowStart, RowStart, RowEnd, RowEnd };
+	for (int32 Corner = 0; Corner < 4; Corner++) {
+		OutCorners[Corner][FaceAxis] = Plane;
+		OutCorners[Corner][ColAxis] = Cols[Corner] * StickerWidth - HalfWidth;
+		OutCorners[Corner][RowAxis] = Rows[Corner] * StickerWidth - HalfWidth;
+	}
+}
+
+void AVRubiksStickerCube::AddQuad(int32 Face, const FVector (&Corners)[4], const FColor& Color, TArray<FVector>& Vertices, TArray<int32>& Triangles, TArray<FVector>& Normals, TArray<FVector2D>& UVs, TArray<FColor>& Colors) const
+{
+	FVector Normal(0);
+	Normal[FVRubiksFaceletModel::GetFaceAxis(Face)] = FVRubiksFaceletModel::IsFacePositive(Face) ? 1 : -1;
+
+	static const FVector2D CornerUVs[4] = { FVector2D(0, 0), FVector2D(1, 0), FVector2D(1, 1), FVector2D(0, 1) };
+	const int32 First = Vertices.Num();
+	for (int32 Corner = 0; Corner < 4; Corner++) {
+		Vertices.Add(Corners[Corner]);
+		Normals.Add(Normal);
+		UVs.Add(CornerUVs[Corner]);
+		Colors.Add(Color);
+	}
+
+	//Front faces wind clockwise in Unreal, which side that is depends on the face
+	const bool bFlip = (((Corners[1] - Corners[0]) ^ (Corners[2] - Corners[0])) | Normal) > 0;
+	Triangles.Append({ First, First + (bFlip ? 2 : 1), First + (bFlip ? 1 : 2) });
+	Triangles.Append({ First, First + (bFlip ? 3 : 2), First + (bFlip ? 2 : 3) });
+}
+
+void AVRubiksStickerCube::UploadFaceRect(int32 Face, const FIntRect& Rect)
+{
+	const uint8* Stickers = Model.GetFaceData(Face).GetData();
+	FVRubiksFaceTexture::UploadRect(FaceTextures[Face], Rect, [this, Stickers](int32 X, int32 Y)
+	{
+		return Palette[Stickers[Y * Size + X]];
+	});
+}
+
+void AVRubiksStickerCube::UpdateFaceRotation(int32 Face)
+{
+	FaceMaterialInstances[Face]->SetScalarParameterValue(FName("FaceRotation"), (float)Model.GetFaceRotation(Face));
+}
+
+void AVRubiksStickerCube::SetHiddenRect(int32 Face, const FIntRect& Rect)
+{
+	const float Scale = 1.0f / Size;
+	FaceMaterialInstances[Face]->SetVectorParameterValue(FName("HiddenRect"), FLinearColor(Rect.Min.X * Scale, Rect.Min.Y * Scale, Rect.Max.X * Scale, Rect.Max.Y * Scale));
+}
+
+void AVRubiksStickerCube::BuildBand(const FVRubiksMove& Move)
+{
+	using namespace VRubiksStickerCube;
+
+	TArray<FVector> Vertices;
+	TArray<int32> Triangles;
+	TArray<FVector> Normals;
+	TArray<FVector2D> UVs;
+	TArray<FColor> Colors;
+	Vertices.Reserve(Size * 16);
+	Triangles.Reserve(Size * 24);
+
+	//4 * Size stickers, the vertices are relative to the rotator at the cube center
+	const FVector Center = GetCenter();
+	for (int32 Face = 0; Face < 6; Face++) {
+		if (FVRubiksFaceletModel::GetFaceAxis(Face) == Move.Axis) {
+			continue;
+		}
+
+		int32 ColAxis, RowAxis;
+		FVRubiksFaceletModel::GetFaceAxes(Face, ColAxis, RowAxis);
+		const int32 FaceAxis = FVRubiksFaceletModel::GetFaceAxis(Face);
+		for (int32 T = 0; T < Size; T++) {
+			FIntVector Cell;
+			Cell[FaceAxis] = FVRubiksFaceletModel::IsFacePositive(Face) ? Size - 1 : 0;
+			Cell[Move.Axis] = Move.Layer;
+			Cell[3 - FaceAxis - Move.Axis] = T;
+
+			FVector Corners[4];
+			GetFaceCorners(Face, Cell[ColAxis] + BandGap, Cell[ColAxis] + 1 - BandGap, Cell[RowAxis] + BandGap, Cell[RowAxis] + 1 - BandGap, BandLift * StickerWidth, Corners);
+			for (FVector& Corner : Corners) {
+				Corner -= Center;
+			}
+			AddQuad(Face, Corners, Palette[Model.GetSticker(Face, Cell[ColAxis], Cell[RowAxis])], Vertices, Triangles, Normals, UVs, Colors);
+		}
+	}
+
+	BandComponent->CreateMeshSection(0, Vertices, Triangles, Normals, UVs, Colors, TArray<FProcMeshTangent>(), false);
+	BandComponent->SetMaterial(0, BandMaterial);
+}
+
+void AVRubiksStickerCube::RotateLayer(int32 Axis, int32 Layer, int32 QuarterTurns, float Speed)
+{
+	const FVRubiksMove Move(Axis, Layer, QuarterTurns);
+	if (bIsAnimating || !Model.IsValidMove(Move)) {
+		return;
+	}
+
+	Steps++;
+	if (Speed <= 0.0f) {
+		CommitMove(Move);
+		return;
+	}
+
+	//Hide the band on the faces and turn its copy instead, an outer layer takes its whole face along
+	BuildBand(Move);
+	for (int32 Face = 0; Face < 6; Face++) {
+		SetHiddenRect(Face, Model.GetBandRect(Face, Move));
+	}
+	if (Move.Layer == 0 || Move.Layer == Size - 1) {
+		FaceComponents[FVRubiksFaceletModel::GetFace(Move.Axis, Move.Layer == Size - 1)]->AttachToComponent(RotatorSceneComponent, FAttachmentTransformRules::KeepWorldTransform);
+	}
+
+	bIsAnimating = true;
+	RotatorSceneComponent->SetRelativeRotation(FRotator(0, 0, 0));
+	ActiveTween = FCTween::Play(
+	FRotator(0, 0, 0).Quaternion(),
+	Move.GetRotation(),
+	[this](FQuat t)
+	{
+		RotatorSceneComponent->SetRelativeRotation(t);
+	},
+	Speed,
+	EFCEase::OutBack)->SetOnComplete([this, Move]() {
+		ActiveTween = nullptr;
+		CommitMove(Move);
+	});
+}
+
+void AVRubiksStickerCube::CommitMove(const FVRubiksMove& Move)
+{
+	Model.ApplyMove(Move);
+
+	//Only the band rows or columns go to the GPU, a turned face only changes its rotation parameter
+	for (int32 Face = 0; Face < 6; Face++) {
+		UploadFaceRect(Face, Model.GetBandRect(Face, Move));
+		SetHiddenRect(Face, FIntRect());
+	}
+	if (Move.Layer == 0 || Move.Layer == Size - 1) {
+		const int32 Face = FVRubiksFaceletModel::GetFace(Move.Axis, Move.Layer == Size - 1);
+		FaceComponents[Face]->AttachToComponent(GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+		FaceComponents[Face]->SetRelativeTransform(FTransform::Identity);
+		UpdateFaceRotation(Face);
+	}
+
+	RotatorSceneComponent->SetRelativeRotation(FRotator(0, 0, 0));
+	BandComponent->ClearAllMeshSections();
+	bIsAnimating = false;
+
+	OnCubeChanged.Broadcast(Steps);
+	if (IsCubeSolved()) {
+		OnCubeSolved.Broadcast();
+	}
+}
+
+void AVRubiksStickerCube::Scramble(int32 TotalSteps)
+{
+	if (bIsAnimating) {
+		return;
+	}
+
+	for (int32 x = 0; x < TotalSteps; x++) {
+		Model.ApplyMove(FVRubiksMove(FMath::RandRange(0, 2), FMath::RandRange(0, Size - 1), FMath::RandBool() ? 1 : -1));
+	}
+
+	//One full upload instead of one per move
+	for (int32 Face = 0; Face < 6; Face++) {
+		UploadFaceRect(Face, FIntRect(0, 0, Size, Size));
+		UpdateFaceRotation(Face);
+	}
+	Steps = 0;
+	OnCubeChanged.Broadcast(Steps);
+}
+
+int32 AVRubiksStickerCube::GetSteps()
+{
+	return Steps;
+}
+
+bool AVRubiksStickerCube::IsCubeSolved()
+{
+	return Model.IsSolved();
+}
+
+bool AVRubiksStickerCube::IsAnimating()
+{
+	return bIsAnimating;
+}
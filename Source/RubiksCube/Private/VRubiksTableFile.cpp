@@ -0,0 +1,157 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VRubiksTableFile.h"
+#include "RubiksCube.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace VRubiksTableFile
+{
+	//The payload starts on its own cache line whatever the header holds
+	static constexpr int64 HeaderSize = 64;
+
+	static TAutoConsoleVariable<bool> CVarVerifyTableFiles(
+		TEXT("Rubiks.VerifyTableFiles"),
+		false,
+		TEXT("Checks the CRC of solver table files every time they are mapped, not only the first time. Reads the whole file up front instead of on demand."));
+
+	//Record of a file whose payload matched its CRC: where it is, when it was written, its size and CRC. Kept in Saved/Rubiks,
+	//Content may be read-only
+	static FString GetVerifiedPath(const FString& Path)
+	{
+		return FPaths::ProjectSavedDir() / TEXT("Rubiks") / FPaths::GetCleanFilename(Path) + TEXT(".verified");
+	}
+
+	static TArray<uint8> MakeVerifiedRecord(const FString& Path, uint32 Crc)
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		FString FullPath = FPaths::ConvertRelativePathToFull(Path);
+		int64 TimeStamp = PlatformFile.GetTimeStamp(*Path).GetTicks();
+		int64 FileSize = PlatformFile.FileSize(*Path);
+
+		TArray<uint8> Record;
+		FMemoryWriter Writer(Record);
+		Writer << FullPath << TimeStamp << FileSize << Crc;
+		return Record;
+	}
+
+	static bool IsVerified(const FString& Path, uint32 Crc)
+	{
+		TArray<uint8> Record;
+		return FFileHelper::LoadFileToArray(Record, *GetVerifiedPath(Path), FILEREAD_Silent) && Record == MakeVerifiedRecord(Path, Crc);
+	}
+
+	static void MarkVerified(const FString& Path, uint32 Crc)
+	{
+		FFileHelper::SaveArrayToFile(MakeVerifiedRecord(Path, Crc), *GetVerifiedPath(Path));
+	}
+}
+
+FVRubiksTableFile::FVRubiksTableFile()
+	: Payload(nullptr)
+{
+}
+
+FVRubiksTableFile::~FVRubiksTableFile()
+{
+	//The region has to go before the file it maps
+	Region.Reset();
+	Handle.Reset();
+}
+
+bool FVRubiksTableFile::Map(const FString& FileName, uint32 Magic, uint16 Version, uint32 Fingerprint, int64 PayloadSize)
+{
+	return MapPath(FPaths::ProjectContentDir() / TEXT("Rubiks") / FileName, Magic, Version, Fingerprint, PayloadSize)
+		|| MapPath(FPaths::ProjectSavedDir() / TEXT("Rubiks") / FileName, Magic, Version, Fingerprint, PayloadSize);
+}
+
+bool FVRubiksTableFile::MapPath(const FString& Path, uint32 Magic, uint16 Version, uint32 Fingerprint, int64 PayloadSize)
+{
+	using namespace VRubiksTableFile;
+
+	Region.Reset();
+	Handle.Reset();
+	Payload = nullptr;
+
+	Handle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Path));
+	if (!Handle || Handle->GetFileSize() != HeaderSize + PayloadSize) {
+		Handle.Reset();
+		return false;
+	}
+
+	Region.Reset(Handle->MapRegion(0, HeaderSize + PayloadSize));
+	if (!Region) {
+		Handle.Reset();
+		return false;
+	}
+
+	//Only the first page is read here
+	TArray<uint8> Header(Region->GetMappedPtr(), HeaderSize);
+	FMemoryReader Reader(Header);
+	uint32 FileMagic = 0;
+	uint16 FileVersion = 0;
+	uint32 FileFingerprint = 0;
+	int64 FilePayloadSize = 0;
+	uint32 Crc = 0;
+	Reader << FileMagic << FileVersion << FileFingerprint << FilePayloadSize << Crc;
+
+	const uint8* FilePayload = Region->GetMappedPtr() + HeaderSize;
+	bool bIsValid = !Reader.IsError() && FileMagic == Magic && FileVersion == Version && FileFingerprint == Fingerprint && FilePayloadSize == PayloadSize;
+
+	//The first time a file is seen its whole payload is read and checked, later runs trust the record and only read the
+	//pages the table touches
+	if (bIsValid && (CVarVerifyTableFiles.GetValueOnAnyThread() || !IsVerified(Path, Crc))) {
+		bIsValid = FCrc::MemCrc32(FilePayload, (int32)PayloadSize) == Crc;
+		if (bIsValid) {
+			MarkVerified(Path, Crc);
+		}
+	}
+	if (!bIsValid) {
+		UE_LOG(LogRubiks, Warning, TEXT("Ignoring stale or corrupt table file %s"), *Path);
+		Region.Reset();
+		Handle.Reset();
+		return false;
+	}
+
+	Payload = FilePayload;
+	return true;
+}
+
+bool FVRubiksTableFile::Write(const FString& FileName, uint32 Magic, uint16 Version, uint32 Fingerprint, const uint8* Data, int64 DataSize)
+{
+	using namespace VRubiksTableFile;
+
+	const FString Path = FPaths::ProjectSavedDir() / TEXT("Rubiks") / FileName;
+	TArray<uint8> Header;
+	FMemoryWriter Writer(Header);
+	uint32 Crc = FCrc::MemCrc32(Data, (int32)DataSize);
+	Writer << Magic << Version << Fingerprint << DataSize << Crc;
+	Header.SetNumZeroed(HeaderSize);
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Path));
+
+	const FString TempPath = Path + TEXT(".tmp");
+	TUniquePtr<IFileHandle> File(PlatformFile.OpenWrite(*TempPath));
+	if (!File || !File->Write(Header.GetData(), Header.Num()) || !File->Write(Data, DataSize)) {
+		File.Reset();
+		PlatformFile.DeleteFile(*TempPath);
+		return false;
+	}
+	File.Reset();
+
+	PlatformFile.DeleteFile(*Path);
+	if (!PlatformFile.MoveFile(*Path, *TempPath)) {
+		return false;
+	}
+
+	//Its CRC was computed from the data just written, mapping it later does not need to read it all again
+	MarkVerified(Path, Crc);
+	return true;
+}
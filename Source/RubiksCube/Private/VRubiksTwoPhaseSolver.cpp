@@ -0,0 +1,959 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VRubiksTwoPhaseSolver.h"
+#include "RubiksCube.h"
+#include "VRubiksFaceletModel.h"
+#include "VRubiksTableFile.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+
+namespace VRubiksTwoPhaseSolver
+{
+	static constexpr int32 NumMoves = 18;
+	static constexpr int32 NumPhase2Moves = 10;
+	static constexpr int32 NumTwists = 2187;
+	static constexpr int32 NumFlips = 2048;
+	static constexpr int32 NumSlices = 495;
+	static constexpr int32 NumPermutations8 = 40320;
+	static constexpr int32 NumSlicePermutations = 24;
+	static constexpr int32 MaxPhase1Length = 20;
+	static constexpr int32 MaxPhase2Length = 18;
+	static constexpr uint8 Unvisited = 0xFF;
+
+	//Move M turns face M / 3 (0 = X layer 0, 1 = X layer 2, 2 = Y layer 0 ... 5 = Z layer 2) by one of these
+	static const int8 MoveQuarterTurns[3] = { 1, 2, -1 };
+
+	static FVRubiksMove GetMove(int32 Move)
+	{
+		const int32 Face = Move / 3;
+		return FVRubiksMove(Face / 2, (Face % 2) * 2, MoveQuarterTurns[Move % 3]);
+	}
+
+	static int32 GetMoveIndex(const FVRubiksMove& Move)
+	{
+		const int32 Turn = Move.QuarterTurns == 1 ? 0 : (Move.QuarterTurns == -1 ? 2 : 1);
+		return (Move.Axis * 2 + Move.Layer / 2) * 3 + Turn;
+	}
+
+	//Phase 2 keeps to Z turns and half turns around X and Y
+	static bool IsPhase2Move(int32 Move)
+	{
+		return Move / 6 == 2 || Move % 3 == 1;
+	}
+
+	//Same face twice in a row is one move, and opposite faces commute so only one of their orders is searched
+	static bool IsRedundant(int32 Move, int32 Previous)
+	{
+		if (Previous == INDEX_NONE) {
+			return false;
+		}
+		const int32 Face = Move / 3;
+		const int32 PreviousFace = Previous / 3;
+		return Face == PreviousFace || (Face / 2 == PreviousFace / 2 && Face < PreviousFace);
+	}
+
+	static int32 Choose(int32 N, int32 K)
+	{
+		if (K < 0 || K > N) {
+			return 0;
+		}
+		int32 Result = 1;
+		for (int32 i = 0; i < K; i++) {
+			Result = Result * (N - i) / (i + 1);
+		}
+		return Result;
+	}
+
+	static int32 GetPermutationIndex(const uint8* Values, int32 Num)
+	{
+		int32 Index = 0;
+		for (int32 i = 0; i < Num; i++) {
+			int32 Smaller = 0;
+			for (int32 j = i + 1; j < Num; j++) {
+				Smaller += Values[j] < Values[i];
+			}
+			Index = Index * (Num - i) + Smaller;
+		}
+		return Index;
+	}
+
+	static void SetPermutationIndex(uint8* OutValues, int32 Num, int32 Index, uint8 FirstValue)
+	{
+		int32 Digits[12];
+		for (int32 i = Num - 1; i >= 0; i--) {
+			Digits[i] = Index % (Num - i);
+			Index /= Num - i;
+		}
+
+		bool bUsed[12] = {};
+		for (int32 i = 0; i < Num; i++) {
+			int32 Value = 0;
+			for (int32 Skip = Digits[i]; bUsed[Value] || Skip > 0; Value++) {
+				Skip -= !bUsed[Value];
+			}
+			bUsed[Value] = true;
+			OutValues[i] = (uint8)(FirstValue + Value);
+		}
+	}
+
+	static bool IsOddPermutation(const uint8* Values, int32 Num)
+	{
+		int32 Inversions = 0;
+		for (int32 i = 0; i < Num; i++) {
+			for (int32 j = i + 1; j < Num; j++) {
+				Inversions += Values[j] < Values[i];
+			}
+		}
+		return (Inversions & 1) != 0;
+	}
+
+	//Cells of the solver's slots, edges 8-11 being the slice
+	struct FSlots
+	{
+		FIntVector Corners[8];
+		FIntVector Edges[12];
+
+		//Outward normals of each corner slot's faces, the Z one first, then the other two in a fixed handedness
+		FIntVector CornerFaces[8][3];
+
+		//Face an edge's reference sticker sits on when it is not flipped: its Z face, or its X face for slice edges
+		FIntVector EdgeFaces[12];
+
+		//Cell index (X + 3 * (Y + 3 * Z)) to corner or edge slot
+		int8 CellToSlot[27];
+
+		FSlots()
+		{
+			FMemory::Memset(CellToSlot, INDEX_NONE, sizeof(CellToSlot));
+
+			int32 NumCorners = 0;
+			int32 NumEdges = 0;
+			int32 NumSliceEdges = 0;
+			for (int32 Z = 2; Z >= 0; Z--) {
+				for (int32 Y = 0; Y < 3; Y++) {
+					for (int32 X = 0; X < 3; X++) {
+						const FIntVector Cell(X, Y, Z);
+						const int32 Outer = (X != 1) + (Y != 1) + (Z != 1);
+						if (Outer == 3) {
+							CellToSlot[X + 3 * (Y + 3 * Z)] = (int8)NumCorners;
+							Corners[NumCorners++] = Cell;
+						} else if (Outer == 2) {
+							const int32 Slot = Z == 1 ? 8 + NumSliceEdges++ : NumEdges++;
+							CellToSlot[X + 3 * (Y + 3 * Z)] = (int8)Slot;
+							Edges[Slot] = Cell;
+						}
+					}
+				}
+			}
+			check(NumCorners == 8 && NumEdges == 8 && NumSliceEdges == 4);
+
+			for (int32 Slot = 0; Slot < 8; Slot++) {
+				const FIntVector Direction = Corners[Slot] - FIntVector(1);
+				const FIntVector ZFace(0, 0, Direction.Z);
+				const FIntVector XFace(Direction.X, 0, 0);
+				const FIntVector YFace(0, Direction.Y, 0);
+
+				//Determinant of (Z, X, Y) is X * Y * Z with unit axes, keep the order whose determinant is positive
+				const bool bRightHanded = Direction.X * Direction.Y * Direction.Z > 0;
+				CornerFaces[Slot][0] = ZFace;
+				CornerFaces[Slot][1] = bRightHanded ? XFace : YFace;
+				CornerFaces[Slot][2] = bRightHanded ? YFace : XFace;
+			}
+
+			for (int32 Slot = 0; Slot < 12; Slot++) {
+				EdgeFaces[Slot] = GetEdgeFace(Edges[Slot]);
+			}
+		}
+
+		static FIntVector GetEdgeFace(const FIntVector& Cell)
+		{
+			const FIntVector Direction = Cell - FIntVector(1);
+			return Direction.Z != 0 ? FIntVector(0, 0, Direction.Z) : FIntVector(Direction.X, 0, 0);
+		}
+
+		int32 GetSlot(const FIntVector& Cell) const
+		{
+			return CellToSlot[Cell.X + 3 * (Cell.Y + 3 * Cell.Z)];
+		}
+	};
+
+	static const FSlots& GetSlots()
+	{
+		static const FSlots Slots;
+		return Slots;
+	}
+
+	//Every table lives in one payload, built here or mapped from TablesFileName, each section starting on a cache line
+	enum ETableSection
+	{
+		TwistMoveSection,
+		FlipMoveSection,
+		SliceMoveSection,
+		CornerPermutationMoveSection,
+		EdgePermutationMoveSection,
+		SlicePermutationMoveSection,
+		SliceTwistPruningSection,
+		SliceFlipPruningSection,
+		CornerPruningSection,
+		EdgePruningSection,
+		NumTableSections
+	};
+
+	static const TCHAR* TablesFileName = TEXT("TwoPhaseTables.bin");
+	static constexpr uint32 TablesMagic = 0x54324252; //RB2T
+	static constexpr uint16 TablesVersion = 1;
+
+	static int64 GetSectionSize(int32 Section)
+	{
+		switch (Section)
+		{
+		case TwistMoveSection:
+			return NumTwists * NumMoves * sizeof(uint16);
+		case FlipMoveSection:
+			return NumFlips * NumMoves * sizeof(uint16);
+		case SliceMoveSection:
+			return NumSlices * NumMoves * sizeof(uint16);
+		case CornerPermutationMoveSection:
+		case EdgePermutationMoveSection:
+			return NumPermutations8 * NumPhase2Moves * sizeof(uint16);
+		case SlicePermutationMoveSection:
+			return NumSlicePermutations * NumPhase2Moves * sizeof(uint16);
+		case SliceTwistPruningSection:
+			return NumSlices * NumTwists;
+		case SliceFlipPruningSection:
+			return NumSlices * NumFlips;
+		default:
+			return NumSlicePermutations * NumPermutations8;
+		}
+	}
+
+	/**
+	 * Basic moves as cubie cubes, move tables for every coordinate ([Coordinate * Moves + Move]) and the pruning tables:
+	 * lower bounds of the moves left, per pair of coordinates, filled by breadth first search from the solved cube.
+	 * Phase 2 tables are only indexed by phase 2 moves, in the order of Phase2Moves.
+	 * The basic moves are always derived from the model, the tables come from the file when it matches them.
+	 */
+	struct FTables
+	{
+		FVRubiksCubieCube Moves[NumMoves];
+		int32 Phase2Moves[NumPhase2Moves];
+
+		const uint16* TwistMove;
+		const uint16* FlipMove;
+		const uint16* SliceMove;
+		const uint16* CornerPermutationMove;
+		const uint16* EdgePermutationMove;
+		const uint16* SlicePermutationMove;
+
+		//[Slice * NumTwists + Twist] and [Slice * NumFlips + Flip]
+		const uint8* SliceTwistPruning;
+		const uint8* SliceFlipPruning;
+
+		//[SlicePermutation * 40320 + CornerPermutation] and [SlicePermutation * 40320 + EdgePermutation]
+		const uint8* CornerPruning;
+		const uint8* EdgePruning;
+
+		int64 SectionOffsets[NumTableSections];
+		int64 PayloadSize;
+
+		FVRubiksTableFile File;
+
+		//Only used when the tables were built by this process
+		TArray<uint8> Storage;
+
+		FTables()
+		{
+			const double StartTime = FPlatformTime::Seconds();
+
+			//Turning a solved model and reading it back gives each move in the model's own conventions
+			FVRubiksCubeModel Model;
+			int32 NumPhase2 = 0;
+			for (int32 Move = 0; Move < NumMoves; Move++) {
+				Model.Reset(3);
+				Model.ApplyMove(GetMove(Move));
+				uint8 Frame = 0;
+				verify(FVRubiksCubieCube::FromModel(Model, Moves[Move], Frame) && Frame == 0);
+				if (IsPhase2Move(Move)) {
+					Phase2Moves[NumPhase2++] = Move;
+				}
+			}
+			check(NumPhase2 == NumPhase2Moves);
+
+			PayloadSize = 0;
+			for (int32 Section = 0; Section < NumTableSections; Section++) {
+				SectionOffsets[Section] = PayloadSize;
+				PayloadSize = Align(PayloadSize + GetSectionSize(Section), 64);
+			}
+
+			//Tables written from other move conventions would be wrong, the moves are part of the file's identity
+			const uint32 Fingerprint = FCrc::MemCrc32(Moves, sizeof(Moves));
+			if (File.Map(TablesFileName, TablesMagic, TablesVersion, Fingerprint, PayloadSize)) {
+				SetSections(File.GetPayload());
+				UE_LOG(LogRubiks, Log, TEXT("Two phase solver tables mapped in %.2f ms"), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+				return;
+			}
+
+			Storage.SetNumZeroed(PayloadSize);
+			SetSections(Storage.GetData());
+			uint8* Data = Storage.GetData();
+			BuildMoveTable(GetSection<uint16>(Data, TwistMoveSection), NumTwists, NumMoves, &FVRubiksCubieCube::SetTwist, &FVRubiksCubieCube::GetTwist);
+			BuildMoveTable(GetSection<uint16>(Data, FlipMoveSection), NumFlips, NumMoves, &FVRubiksCubieCube::SetFlip, &FVRubiksCubieCube::GetFlip);
+			BuildMoveTable(GetSection<uint16>(Data, SliceMoveSection), NumSlices, NumMoves, &FVRubiksCubieCube::SetSlice, &FVRubiksCubieCube::GetSlice);
+			BuildMoveTable(GetSection<uint16>(Data, CornerPermutationMoveSection), NumPermutations8, NumPhase2Moves, &FVRubiksCubieCube::SetCornerPermutation, &FVRubiksCubieCube::GetCornerPermutation);
+			BuildMoveTable(GetSection<uint16>(Data, EdgePermutationMoveSection), NumPermutations8, NumPhase2Moves, &FVRubiksCubieCube::SetEdgePermutation, &FVRubiksCubieCube::GetEdgePermutation);
+			BuildMoveTable(GetSection<uint16>(Data, SlicePermutationMoveSection), NumSlicePermutations, NumPhase2Moves, &FVRubiksCubieCube::SetSlicePermutation, &FVRubiksCubieCube::GetSlicePermutation);
+
+			BuildPruningTable(GetSection<uint8>(Data, SliceTwistPruningSection), SliceMove, NumSlices, TwistMove, NumTwists, NumMoves);
+			BuildPruningTable(GetSection<uint8>(Data, SliceFlipPruningSection), SliceMove, NumSlices, FlipMove, NumFlips, NumMoves);
+			BuildPruningTable(GetSection<uint8>(Data, CornerPruningSection), SlicePermutationMove, NumSlicePermutations, CornerPermutationMove, NumPermutations8, NumPhase2Moves);
+			BuildPruningTable(GetSection<uint8>(Data, EdgePruningSection), SlicePermutationMove, NumSlicePermutations, EdgePermutationMove, NumPermutations8, NumPhase2Moves);
+
+			const bool bSaved = FVRubiksTableFile::Write(TablesFileName, TablesMagic, TablesVersion, Fingerprint, Data, PayloadSize);
+			UE_LOG(LogRubiks, Log, TEXT("Two phase solver tables built in %.0f ms%s"), (FPlatformTime::Seconds() - StartTime) * 1000.0, bSaved ? TEXT(" and saved") : TEXT(""));
+		}
+
+		template<typename T>
+		T* GetSection(uint8* Data, int32 Section) const
+		{
+			return reinterpret_cast<T*>(Data + SectionOffsets[Section]);
+		}
+
+		template<typename T>
+		const T* GetSection(const uint8* Data, int32 Section) const
+		{
+			return reinterpret_cast<const T*>(Data + SectionOffsets[Section]);
+		}
+
+		void SetSections(const uint8* Data)
+		{
+			TwistMove = GetSection<uint16>(Data, TwistMoveSection);
+			FlipMove = GetSection<uint16>(Data, FlipMoveSection);
+			SliceMove = GetSection<uint16>(Data, SliceMoveSection);
+			CornerPermutationMove = GetSection<uint16>(Data, CornerPermutationMoveSection);
+			EdgePermutationMove = GetSection<uint16>(Data, EdgePermutationMoveSection);
+			SlicePermutationMove = GetSection<uint16>(Data, SlicePermutationMoveSection);
+			SliceTwistPruning = GetSection<uint8>(Data, SliceTwistPruningSection);
+			SliceFlipPruning = GetSection<uint8>(Data, SliceFlipPruningSection);
+			CornerPruning = GetSection<uint8>(Data, CornerPruningSection);
+			EdgePruning = GetSection<uint8>(Data, EdgePruningSection);
+		}
+
+		void BuildMoveTable(uint16* OutTable, int32 NumCoordinates, int32 NumTableMoves, void (FVRubiksCubieCube::*Set)(int32), int32 (FVRubiksCubieCube::*Get)() const) const
+		{
+			for (int32 Coordinate = 0; Coordinate < NumCoordinates; Coordinate++) {
+				FVRubiksCubieCube Cube;
+				(Cube.*Set)(Coordinate);
+				for (int32 Index = 0; Index < NumTableMoves; Index++) {
+					FVRubiksCubieCube Moved = Cube;
+					Moved.Multiply(Moves[NumTableMoves == NumMoves ? Index : Phase2Moves[Index]]);
+					OutTable[Coordinate * NumTableMoves + Index] = (uint16)(Moved.*Get)();
+				}
+			}
+		}
+
+		//Both coordinates are solved at 0
+		static void BuildPruningTable(uint8* OutTable, const uint16* MoveA, int32 NumA, const uint16* MoveB, int32 NumB, int32 NumTableMoves)
+		{
+			const int32 NumEntries = NumA * NumB;
+			FMemory::Memset(OutTable, Unvisited, NumEntries);
+			OutTable[0] = 0;
+
+			int32 NumFilled = 1;
+			for (uint8 Depth = 0; NumFilled < NumEntries; Depth++) {
+				const int32 FilledBefore = NumFilled;
+				for (int32 Entry = 0; Entry < NumEntries; Entry++) {
+					if (OutTable[Entry] != Depth) {
+						continue;
+					}
+
+					const int32 A = Entry / NumB;
+					const int32 B = Entry % NumB;
+					for (int32 Move = 0; Move < NumTableMoves; Move++) {
+						const int32 Next = MoveA[A * NumTableMoves + Move] * NumB + MoveB[B * NumTableMoves + Move];
+						if (OutTable[Next] == Unvisited) {
+							OutTable[Next] = Depth + 1;
+							NumFilled++;
+						}
+					}
+				}
+				if (NumFilled == FilledBefore) {
+					break;
+				}
+			}
+			check(NumFilled == NumEntries);
+		}
+	};
+
+	static const FTables& GetTables()
+	{
+		static const FTables Tables;
+		return Tables;
+	}
+
+	//One solve. Moves holds the path being searched, phase 1 then phase 2
+	struct FSearch
+	{
+		const FTables& Tables;
+		const FVRubiksCubieCube& Cube;
+		const FVRubiksTwoPhaseSolver::FSettings& Settings;
+
+		double Deadline;
+		int32 NumNodes;
+		bool bStop;
+
+		int32 Moves[MaxPhase1Length + MaxPhase2Length];
+		int32 BestLength;
+		TArray<int32> BestMoves;
+
+		FSearch(const FVRubiksCubieCube& InCube, const FVRubiksTwoPhaseSolver::FSettings& InSettings)
+			: Tables(GetTables())
+			, Cube(InCube)
+			, Settings(InSettings)
+			, Deadline(FPlatformTime::Seconds() + InSettings.TimeBudgetSeconds)
+			, NumNodes(0)
+			, bStop(false)
+			, BestLength(MaxPhase1Length + MaxPhase2Length + 1)
+		{
+		}
+
+		void Run()
+		{
+			const int32 Twist = Cube.GetTwist();
+			const int32 Flip = Cube.GetFlip();
+			const int32 Slice = Cube.GetSlice();
+			for (int32 Length = GetPhase1Distance(Twist, Flip, Slice); Length <= MaxPhase1Length && Length < BestLength && !bStop; Length++) {
+				SearchPhase1(Twist, Flip, Slice, 0, Length);
+			}
+		}
+
+		bool ShouldStop()
+		{
+			//The clock is only read every few thousand nodes
+			if (!bStop && (++NumNodes & 4095) == 0) {
+				bStop = FPlatformTime::Seconds() > Deadline || (Settings.bCancel && Settings.bCancel->load(std::memory_order_relaxed));
+			}
+			return bStop;
+		}
+
+		int32 GetPhase1Distance(int32 Twist, int32 Flip, int32 Slice) const
+		{
+			return FMath::Max(Tables.SliceTwistPruning[Slice * NumTwists + Twist], Tables.SliceFlipPruning[Slice * NumFlips + Flip]);
+		}
+
+		int32 GetPhase2Distance(int32 Corner, int32 Edge, int32 SlicePermutation) const
+		{
+			return FMath::Max(Tables.CornerPruning[SlicePermutation * NumPermutations8 + Corner], Tables.EdgePruning[SlicePermutation * NumPermutations8 + Edge]);
+		}
+
+		void SearchPhase1(int32 Twist, int32 Flip, int32 Slice, int32 Depth, int32 Remaining)
+		{
+			if (Remaining == 0) {
+				//A last move phase 2 could make itself was already tried as part of a shorter phase 1
+				if (Depth == 0 || !IsPhase2Move(Moves[Depth - 1])) {
+					StartPhase2(Depth);
+				}
+				return;
+			}
+
+			const int32 Previous = Depth > 0 ? Moves[Depth - 1] : INDEX_NONE;
+			for (int32 Move = 0; Move < NumMoves && !bStop; Move++) {
+				if (IsRedundant(Move, Previous) || ShouldStop()) {
+					continue;
+				}
+
+				const int32 NextTwist = Tables.TwistMove[Twist * NumMoves + Move];
+				const int32 NextFlip = Tables.FlipMove[Flip * NumMoves + Move];
+				const int32 NextSlice = Tables.SliceMove[Slice * NumMoves + Move];
+				if (GetPhase1Distance(NextTwist, NextFlip, NextSlice) >= Remaining) {
+					continue;
+				}
+
+				Moves[Depth] = Move;
+				SearchPhase1(NextTwist, NextFlip, NextSlice, Depth + 1, Remaining - 1);
+			}
+		}
+
+		void StartPhase2(int32 Phase1Length)
+		{
+			FVRubiksCubieCube Reduced = Cube;
+			for (int32 Index = 0; Index < Phase1Length; Index++) {
+				Reduced.Multiply(Tables.Moves[Moves[Index]]);
+			}
+
+			const int32 Corner = Reduced.GetCornerPermutation();
+			const int32 Edge = Reduced.GetEdgePermutation();
+			const int32 SlicePermutation = Reduced.GetSlicePermutation();
+			const int32 MaxLength = FMath::Min(BestLength - 1 - Phase1Length, MaxPhase2Length);
+			for (int32 Length = GetPhase2Distance(Corner, Edge, SlicePermutation); Length <= MaxLength && !bStop; Length++) {
+				if (SearchPhase2(Corner, Edge, SlicePermutation, Phase1Length, Length)) {
+					BestLength = Phase1Length + Length;
+					BestMoves = TArray<int32>(Moves, BestLength);
+					bStop = BestLength <= Settings.TargetLength;
+					return;
+				}
+			}
+		}
+
+		bool SearchPhase2(int32 Corner, int32 Edge, int32 SlicePermutation, int32 Depth, int32 Remaining)
+		{
+			if (Remaining == 0) {
+				return Corner == 0 && Edge == 0 && SlicePermutation == 0;
+			}
+
+			const int32 Previous = Depth > 0 ? Moves[Depth - 1] : INDEX_NONE;
+			for (int32 Index = 0; Index < NumPhase2Moves && !bStop; Index++) {
+				const int32 Move = Tables.Phase2Moves[Index];
+				if (IsRedundant(Move, Previous) || ShouldStop()) {
+					continue;
+				}
+
+				const int32 NextCorner = Tables.CornerPermutationMove[Corner * NumPhase2Moves + Index];
+				const int32 NextEdge = Tables.EdgePermutationMove[Edge * NumPhase2Moves + Index];
+				const int32 NextSlicePermutation = Tables.SlicePermutationMove[SlicePermutation * NumPhase2Moves + Index];
+				if (GetPhase2Distance(NextCorner, NextEdge, NextSlicePermutation) >= Remaining) {
+					continue;
+				}
+
+				Moves[Depth] = Move;
+				if (SearchPhase2(NextCorner, NextEdge, NextSlicePermutation, Depth + 1, Remaining - 1)) {
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+
+	static FVRubiksCubieCube MakeRandomCube(FRandomStream& Random)
+	{
+		FVRubiksCubieCube Cube;
+		Cube.SetTwist(Random.RandHelper(NumTwists));
+		Cube.SetFlip(Random.RandHelper(NumFlips));
+		for (int32 i = 7; i > 0; i--) {
+			Swap(Cube.CornerPerm[i], Cube.CornerPerm[Random.RandHelper(i + 1)]);
+		}
+		for (int32 i = 11; i > 0; i--) {
+			Swap(Cube.EdgePerm[i], Cube.EdgePerm[Random.RandHelper(i + 1)]);
+		}
+		if (IsOddPermutation(Cube.CornerPerm, 8) != IsOddPermutation(Cube.EdgePerm, 12)) {
+			Swap(Cube.EdgePerm[0], Cube.EdgePerm[1]);
+		}
+		return Cube;
+	}
+
+	//Solves the same seeded random positions every run and checks every solution
+	static void RunBenchmark(const TArray<FString>& Args)
+	{
+		const int32 NumPositions = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10000;
+		FVRubiksTwoPhaseSolver::FSettings Settings;
+		if (Args.Num() > 1) {
+			Settings.TargetLength = FCString::Atoi(*Args[1]);
+		}
+
+		FVRubiksTwoPhaseSolver::BuildTables();
+
+		const FVRubiksCubieCube Solved;
+		FRandomStream Random(0x52424B53);
+		double TotalSeconds = 0.0;
+		double MaxSeconds = 0.0;
+		int64 TotalLength = 0;
+		int32 MaxLength = 0;
+		int32 NumFailed = 0;
+		int32 NumOverTarget = 0;
+		for (int32 Position = 0; Position < NumPositions; Position++) {
+			const FVRubiksCubieCube Cube = MakeRandomCube(Random);
+
+			TArray<FVRubiksMove> Solution;
+			const double StartTime = FPlatformTime::Seconds();
+			const bool bSolved = FVRubiksTwoPhaseSolver::Solve(Cube, Settings, Solution);
+			const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+			FVRubiksCubieCube Check = Cube;
+			for (const FVRubiksMove& Move : Solution) {
+				Check.Multiply(GetTables().Moves[GetMoveIndex(Move)]);
+			}
+			if (!bSolved || FMemory::Memcmp(&Check, &Solved, sizeof(FVRubiksCubieCube)) != 0) {
+				NumFailed++;
+				continue;
+			}
+
+			TotalSeconds += Seconds;
+			MaxSeconds = FMath::Max(MaxSeconds, Seconds);
+			TotalLength += Solution.Num();
+			MaxLength = FMath::Max(MaxLength, Solution.Num());
+			NumOverTarget += Solution.Num() > Settings.TargetLength;
+		}
+
+		const int32 NumSolved = FMath::Max(NumPositions - NumFailed, 1);
+		UE_LOG(LogRubiks, Display, TEXT("Two phase solver: %d positions, %d failed, %.3f ms average, %.3f ms max, %.2f moves average, %d max, %d over %d moves"),
+			NumPositions, NumFailed, TotalSeconds * 1000.0 / NumSolved, MaxSeconds * 1000.0, (double)TotalLength / NumSolved, MaxLength, NumOverTarget, Settings.TargetLength);
+	}
+
+	static FAutoConsoleCommand BenchmarkCommand(
+		TEXT("Rubiks.SolverBenchmark"),
+		TEXT("Solves seeded random 3x3 positions with the two phase solver and logs time and length. Usage: Rubiks.SolverBenchmark [Positions=10000] [TargetLength=21]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&RunBenchmark));
+}
+
+FVRubiksCubieCube::FVRubiksCubieCube()
+{
+	for (uint8 i = 0; i < 8; i++) {
+		CornerPerm[i] = i;
+		CornerOri[i] = 0;
+	}
+	for (uint8 i = 0; i < 12; i++) {
+		EdgePerm[i] = i;
+		EdgeOri[i] = 0;
+	}
+}
+
+void FVRubiksCubieCube::Multiply(const FVRubiksCubieCube& Move)
+{
+	//Slot i receives whatever sat in the slot the move brings there, with the move's own twist on top
+	uint8 NewCornerPerm[8];
+	uint8 NewCornerOri[8];
+	for (int32 i = 0; i < 8; i++) {
+		NewCornerPerm[i] = CornerPerm[Move.CornerPerm[i]];
+		NewCornerOri[i] = (CornerOri[Move.CornerPerm[i]] + Move.CornerOri[i]) % 3;
+	}
+
+	uint8 NewEdgePerm[12];
+	uint8 NewEdgeOri[12];
+	for (int32 i = 0; i < 12; i++) {
+		NewEdgePerm[i] = EdgePerm[Move.EdgePerm[i]];
+		NewEdgeOri[i] = EdgeOri[Move.EdgePerm[i]] ^ Move.EdgeOri[i];
+	}
+
+	FMemory::Memcpy(CornerPerm, NewCornerPerm, sizeof(CornerPerm));
+	FMemory::Memcpy(CornerOri, NewCornerOri, sizeof(CornerOri));
+	FMemory::Memcpy(EdgePerm, NewEdgePerm, sizeof(EdgePerm));
+	FMemory::Memcpy(EdgeOri, NewEdgeOri, sizeof(EdgeOri));
+}
+
+bool FVRubiksCubieCube::IsSolvable() const
+{
+	uint32 CornersSeen = 0;
+	uint32 EdgesSeen = 0;
+	int32 TwistSum = 0;
+	int32 FlipSum = 0;
+	for (int32 i = 0; i < 8; i++) {
+		if (CornerPerm[i] >= 8 || CornerOri[i] >= 3) {
+			return false;
+		}
+		CornersSeen |= 1u << CornerPerm[i];
+		TwistSum += CornerOri[i];
+	}
+	for (int32 i = 0; i < 12; i++) {
+		if (EdgePerm[i] >= 12 || EdgeOri[i] >= 2) {
+			return false;
+		}
+		EdgesSeen |= 1u << EdgePerm[i];
+		FlipSum += EdgeOri[i];
+	}
+
+	return CornersSeen == 0xFF && EdgesSeen == 0xFFF && TwistSum % 3 == 0 && FlipSum % 2 == 0
+		&& VRubiksTwoPhaseSolver::IsOddPermutation(CornerPerm, 8) == VRubiksTwoPhaseSolver::IsOddPermutation(EdgePerm, 12);
+}
+
+int32 FVRubiksCubieCube::GetTwist() const
+{
+	int32 Twist = 0;
+	for (int32 i = 0; i < 7; i++) {
+		Twist = Twist * 3 + CornerOri[i];
+	}
+	return Twist;
+}
+
+void FVRubiksCubieCube::SetTwist(int32 Twist)
+{
+	int32 Sum = 0;
+	for (int32 i = 6; i >= 0; i--) {
+		CornerOri[i] = (uint8)(Twist % 3);
+		Sum += CornerOri[i];
+		Twist /= 3;
+	}
+	CornerOri[7] = (uint8)((3 - Sum % 3) % 3);
+}
+
+int32 FVRubiksCubieCube::GetFlip() const
+{
+	int32 Flip = 0;
+	for (int32 i = 0; i < 11; i++) {
+		Flip = Flip * 2 + EdgeOri[i];
+	}
+	return Flip;
+}
+
+void FVRubiksCubieCube::SetFlip(int32 Flip)
+{
+	int32 Sum = 0;
+	for (int32 i = 10; i >= 0; i--) {
+		EdgeOri[i] = (uint8)(Flip & 1);
+		Sum += EdgeOri[i];
+		Flip >>= 1;
+	}
+	EdgeOri[11] = (uint8)(Sum & 1);
+}
+
+int32 FVRubiksCubieCube::GetSlice() const
+{
+	//Combination index of the four slots holding slice edges, counted from the last slot so the solved cube is 0
+	int32 Slice = 0;
+	int32 Found = 0;
+	for (int32 i = 11; i >= 0; i--) {
+		if (EdgePerm[i] >= 8) {
+			Slice += VRubiksTwoPhaseSolver::Choose(11 - i, Found + 1);
+			Found++;
+		}
+	}
+	return Slice;
+}
+
+void FVRubiksCubieCube::SetSlice(int32 Slice)
+{
+	uint8 NextSliceEdge = 8;
+	uint8 NextOtherEdge = 0;
+	int32 Left = 4;
+	for (int32 i = 0; i < 12; i++) {
+		const int32 Combinations = VRubiksTwoPhaseSolver::Choose(11 - i, Left);
+		if (Left > 0 && Slice >= Combinations) {
+			Slice -= Combinations;
+			Left--;
+			EdgePerm[i] = NextSliceEdge++;
+		} else {
+			EdgePerm[i] = NextOtherEdge++;
+		}
+	}
+}
+
+int32 FVRubiksCubieCube::GetCornerPermutation() const
+{
+	return VRubiksTwoPhaseSolver::GetPermutationIndex(CornerPerm, 8);
+}
+
+void FVRubiksCubieCube::SetCornerPermutation(int32 Permutation)
+{
+	VRubiksTwoPhaseSolver::SetPermutationIndex(CornerPerm, 8, Permutation, 0);
+}
+
+int32 FVRubiksCubieCube::GetEdgePermutation() const
+{
+	return VRubiksTwoPhaseSolver::GetPermutationIndex(EdgePerm, 8);
+}
+
+void FVRubiksCubieCube::SetEdgePermutation(int32 Permutation)
+{
+	VRubiksTwoPhaseSolver::SetPermutationIndex(EdgePerm, 8, Permutation, 0);
+}
+
+int32 FVRubiksCubieCube::GetSlicePermutation() const
+{
+	return VRubiksTwoPhaseSolver::GetPermutationIndex(EdgePerm + 8, 4);
+}
+
+void FVRubiksCubieCube::SetSlicePermutation(int32 Permutation)
+{
+	VRubiksTwoPhaseSolver::SetPermutationIndex(EdgePerm + 8, 4, Permutation, 8);
+}
+
+bool FVRubiksCubieCube::FromModel(const FVRubiksCubeModel& Model, FVRubiksCubieCube& OutCube, uint8& OutFrame)
+{
+	if (Model.GetSize() != 3) {
+		return false;
+	}
+
+	//The up and front centers only move with the whole cube, where they point gives the frame
+	FIntVector UpDirection(0);
+	FIntVector FrontDirection(0);
+	for (int32 Index = 0; Index < Model.NumPieces(); Index++) {
+		const FVRubiksCubeModel::FPiece& Piece = Model.GetPiece(Index);
+		if (Piece.HomeCell == FIntVector(1, 1, 2)) {
+			UpDirection = Piece.Cell - FIntVector(1);
+		} else if (Piece.HomeCell == FIntVector(0, 1, 1)) {
+			FrontDirection = Piece.Cell - FIntVector(1);
+		}
+	}
+
+	int32 Frame = INDEX_NONE;
+	for (int32 Orientation = 0; Orientation < FVRubiksCubeModel::NumOrientations(); Orientation++) {
+		if (FVRubiksCubeModel::RotateByOrientation(Orientation, FIntVector(0, 0, 1)) == UpDirection
+			&& FVRubiksCubeModel::RotateByOrientation(Orientation, FIntVector(-1, 0, 0)) == FrontDirection) {
+			Frame = Orientation;
+			break;
+		}
+	}
+	if (Frame == INDEX_NONE) {
+		return false;
+	}
+	const uint8 ToSolverFrame = FVRubiksCubeModel::InverseOrientation((uint8)Frame);
+
+	const VRubiksTwoPhaseSolver::FSlots& Slots = VRubiksTwoPhaseSolver::GetSlots();
+	auto GetPieceInSlot = [&Model, Frame](const FIntVector& SlotCell) -> const FVRubiksCubeModel::FPiece*
+	{
+		const int32 Index = Model.GetPieceAtCell(FVRubiksCubeModel::RotateByOrientation((uint8)Frame, SlotCell - FIntVector(1)) + FIntVector(1));
+		return Index != INDEX_NONE ? &Model.GetPiece(Index) : nullptr;
+	};
+
+	for (int32 Slot = 0; Slot < 8; Slot++) {
+		const FVRubiksCubeModel::FPiece* Piece = GetPieceInSlot(Slots.Corners[Slot]);
+		const int32 Cubie = Piece ? Slots.GetSlot(Piece->HomeCell) : INDEX_NONE;
+		if (Cubie == INDEX_NONE || Slots.Corners[Cubie] != Piece->HomeCell) {
+			return false;
+		}
+
+		//Where the cubie's Z sticker points now, seen from the solver's frame
+		const FIntVector Sticker(0, 0, Piece->HomeCell.Z - 1);
+		const FIntVector Direction = FVRubiksCubeModel::RotateByOrientation(ToSolverFrame, FVRubiksCubeModel::RotateByOrientation(Piece->Orientation, Sticker));
+		OutCube.CornerPerm[Slot] = (uint8)Cubie;
+		OutCube.CornerOri[Slot] = Direction == Slots.CornerFaces[Slot][0] ? 0 : (Direction == Slots.CornerFaces[Slot][1] ? 1 : 2);
+	}
+
+	for (int32 Slot = 0; Slot < 12; Slot++) {
+		const FVRubiksCubeModel::FPiece* Piece = GetPieceInSlot(Slots.Edges[Slot]);
+		const int32 Cubie = Piece ? Slots.GetSlot(Piece->HomeCell) : INDEX_NONE;
+		if (Cubie == INDEX_NONE || Slots.Edges[Cubie] != Piece->HomeCell) {
+			return false;
+		}
+
+		const FIntVector Sticker = VRubiksTwoPhaseSolver::FSlots::GetEdgeFace(Piece->HomeCell);
+		const FIntVector Direction = FVRubiksCubeModel::RotateByOrientation(ToSolverFrame, FVRubiksCubeModel::RotateByOrientation(Piece->Orientation, Sticker));
+		OutCube.EdgePerm[Slot] = (uint8)Cubie;
+		OutCube.EdgeOri[Slot] = Direction == Slots.EdgeFaces[Slot] ? 0 : 1;
+	}
+
+	OutFrame = (uint8)Frame;
+	return OutCube.IsSolvable();
+}
+
+bool FVRubiksCubieCube::FromStickers(TFunctionRef<uint8(const FIntVector& Cell, const FIntVector& Normal)> GetColor, FVRubiksCubieCube& OutCube, uint8& OutFrame)
+{
+	auto GetFaceNormal = [](int32 Face)
+	{
+		FIntVector Normal(0);
+		Normal[FVRubiksFaceletModel::GetFaceAxis(Face)] = FVRubiksFaceletModel::IsFacePositive(Face) ? 1 : -1;
+		return Normal;
+	};
+
+	//The faces showing the up and front colors give the frame, like the centers of a model
+	FIntVector UpDirection(0);
+	FIntVector FrontDirection(0);
+	for (int32 Face = 0; Face < 6; Face++) {
+		const FIntVector Normal = GetFaceNormal(Face);
+		const uint8 Color = GetColor(FIntVector(1) + Normal, Normal);
+		if (Color == FVRubiksFaceletModel::GetFace(2, true)) {
+			UpDirection = Normal;
+		} else if (Color == FVRubiksFaceletModel::GetFace(0, false)) {
+			FrontDirection = Normal;
+		}
+	}
+
+	int32 Frame = INDEX_NONE;
+	for (int32 Orientation = 0; Orientation < FVRubiksCubeModel::NumOrientations(); Orientation++) {
+		if (FVRubiksCubeModel::RotateByOrientation(Orientation, FIntVector(0, 0, 1)) == UpDirection
+			&& FVRubiksCubeModel::RotateByOrientation(Orientation, FIntVector(-1, 0, 0)) == FrontDirection) {
+			Frame = Orientation;
+			break;
+		}
+	}
+	if (Frame == INDEX_NONE) {
+		return false;
+	}
+
+	//Colors of a slot's stickers with the faces they are on (in the solver's frame), the cell of the cubie they belong to
+	const VRubiksTwoPhaseSolver::FSlots& Slots = VRubiksTwoPhaseSolver::GetSlots();
+	auto ReadSlot = [&GetColor, &GetFaceNormal, Frame](const FIntVector& SlotCell, uint8 Colors[3], FIntVector Faces[3]) -> FIntVector
+	{
+		const FIntVector Direction = SlotCell - FIntVector(1);
+		const FIntVector Cell = FVRubiksCubeModel::RotateByOrientation((uint8)Frame, Direction) + FIntVector(1);
+		FIntVector HomeCell(1);
+		int32 NumFaces = 0;
+		for (int32 Axis = 0; Axis < 3; Axis++) {
+			if (Direction[Axis] != 0) {
+				FIntVector Face(0);
+				Face[Axis] = Direction[Axis];
+				Colors[NumFaces] = GetColor(Cell, FVRubiksCubeModel::RotateByOrientation((uint8)Frame, Face));
+				HomeCell = HomeCell + GetFaceNormal(Colors[NumFaces]);
+				Faces[NumFaces++] = Face;
+			}
+		}
+		return HomeCell;
+	};
+	auto GetCubie = [&Slots](const FIntVector& HomeCell, const FIntVector* Cells) -> int32
+	{
+		if (HomeCell.X < 0 || HomeCell.X > 2 || HomeCell.Y < 0 || HomeCell.Y > 2 || HomeCell.Z < 0 || HomeCell.Z > 2) {
+			return INDEX_NONE;
+		}
+		const int32 Cubie = Slots.GetSlot(HomeCell);
+		return Cubie != INDEX_NONE && Cells[Cubie] == HomeCell ? Cubie : INDEX_NONE;
+	};
+
+	uint8 Colors[3];
+	FIntVector Faces[3];
+	for (int32 Slot = 0; Slot < 8; Slot++) {
+		const int32 Cubie = GetCubie(ReadSlot(Slots.Corners[Slot], Colors, Faces), Slots.Corners);
+		if (Cubie == INDEX_NONE) {
+			return false;
+		}
+
+		//The sticker of the Z color, a corner has exactly one
+		int32 ZSticker = 0;
+		while (FVRubiksFaceletModel::GetFaceAxis(Colors[ZSticker]) != 2) {
+			ZSticker++;
+		}
+		OutCube.CornerPerm[Slot] = (uint8)Cubie;
+		OutCube.CornerOri[Slot] = Faces[ZSticker] == Slots.CornerFaces[Slot][0] ? 0 : (Faces[ZSticker] == Slots.CornerFaces[Slot][1] ? 1 : 2);
+	}
+
+	for (int32 Slot = 0; Slot < 12; Slot++) {
+		const int32 Cubie = GetCubie(ReadSlot(Slots.Edges[Slot], Colors, Faces), Slots.Edges);
+		if (Cubie == INDEX_NONE) {
+			return false;
+		}
+
+		const int32 ReferenceSticker = GetFaceNormal(Colors[0]) == VRubiksTwoPhaseSolver::FSlots::GetEdgeFace(Slots.Edges[Cubie]) ? 0 : 1;
+		OutCube.EdgePerm[Slot] = (uint8)Cubie;
+		OutCube.EdgeOri[Slot] = Faces[ReferenceSticker] == Slots.EdgeFaces[Slot] ? 0 : 1;
+	}
+
+	OutFrame = (uint8)Frame;
+	return OutCube.IsSolvable();
+}
+
+bool FVRubiksTwoPhaseSolver::Solve(const FVRubiksCubieCube& Cube, const FSettings& Settings, TArray<FVRubiksMove>& OutMoves)
+{
+	OutMoves.Reset();
+	if (!Cube.IsSolvable()) {
+		return false;
+	}
+
+	VRubiksTwoPhaseSolver::FSearch Search(Cube, Settings);
+	Search.Run();
+	if (Search.BestMoves.Num() == 0 && Search.BestLength != 0) {
+		return false;
+	}
+
+	for (int32 Move : Search.BestMoves) {
+		OutMoves.Add(VRubiksTwoPhaseSolver::GetMove(Move));
+	}
+	return true;
+}
+
+bool FVRubiksTwoPhaseSolver::SolveModel(const FVRubiksCubeModel& Model, const FSettings& Settings, TArray<FVRubiksMove>& OutMoves)
+{
+	FVRubiksCubieCube Cube;
+	uint8 Frame = 0;
+	if (!FVRubiksCubieCube::FromModel(Model, Cube, Frame) || !Solve(Cube, Settings, OutMoves)) {
+		OutMoves.Reset();
+		return false;
+	}
+
+	for (FVRubiksMove& Move : OutMoves) {
+		Move = FVRubiksCubeModel::ReorientMove(Move, Frame, 3);
+	}
+	return true;
+}
+
+void FVRubiksTwoPhaseSolver::BuildTables()
+{
+	VRubiksTwoPhaseSolver::GetTables();
+}
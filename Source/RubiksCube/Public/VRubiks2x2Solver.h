@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VRubiksCubeModel.h"
+
+/**
+ * Optimal solver for the 2x2 from a complete distance table. With the corner at cell (0, 0, 0) held in place, turning only
+ * the three layers away from it (layer 1 of each axis, quarter or half turns), the cube has 7! * 3^6 = 3,674,160 states.
+ * The table keeps each state's distance to solved modulo 3 in 2 bits (about 900 KB): from any state exactly the neighbors
+ * one move closer hold the previous value, so walking down finds an optimal solution, and its length, in O(depth) lookups.
+ * The table is built once by a parallel breadth first search and then mapped from Saved/Rubiks.
+ */
+class RUBIKSCUBE_API FVRubiks2x2Solver
+{
+public:
+	static constexpr int32 NumStates = 3674160;
+
+	//Optimal solution as moves on the model, false when it is not a 2x2
+	static bool SolveModel(const FVRubiksCubeModel& Model, TArray<FVRubiksMove>& OutMoves);
+
+	//Fewest moves (quarter or half turns) that solve the model, INDEX_NONE when it is not a 2x2
+	static int32 GetDistance(const FVRubiksCubeModel& Model);
+
+	//Builds or maps the table now, blocking, safe from any thread
+	static void BuildTable();
+
+	//Builds the table on a worker task unless that was already started
+	static void BuildTableAsync();
+
+	//True once queries no longer wait for the table
+	static bool IsTableReady();
+};
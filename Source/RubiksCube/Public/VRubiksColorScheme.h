@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "VRubiksColorScheme.generated.h"
+
+class UMaterialParameterCollection;
+
+UENUM(BlueprintType)
+enum class EVRubiksColorScheme : uint8
+{
+	Standard UMETA(DisplayName = "Standard"),
+	ColorBlind UMETA(DisplayName = "Color-blind safe"),
+	HighContrast UMETA(DisplayName = "High contrast")
+};
+
+/**
+ * Sticker color schemes. Sticker materials read the six face colors from a palette (PaletteColor0..5, in the layout face
+ * order), either as parameters of their own instance or from a shared material parameter collection.
+ * With the collection, switching the scheme of every cube in the world is six parameter writes.
+ */
+UCLASS()
+class RUBIKSCUBE_API UVRubiksColorSchemeLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintPure, Category = "Rubiks")
+	static TArray<FLinearColor> GetSchemeColors(EVRubiksColorScheme Scheme);
+
+	//Writes the colors in the world's instance of the palette collection
+	UFUNCTION(BlueprintCallable, Category = "Rubiks", meta = (WorldContext = "WorldContextObject"))
+	static void ApplyToPalette(const UObject* WorldContextObject, UMaterialParameterCollection* Palette, const TArray<FLinearColor>& Colors);
+
+	//PaletteColor0..5
+	static FName GetPaletteParameterName(int32 Index);
+};
@@ -4,14 +4,26 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "VRubiksColorScheme.h"
+#include "VRubiksCubeLayout.h"
+#include "VRubiksCubeMesh.h"
+#include "VRubiksCubeModel.h"
+#include "VRubiksLodPolicy.h"
+#include "VRubiksMoveJournal.h"
 #include "VRubiksCube.generated.h"
 
 #define DRAG_DISTANCE 15
 #define CAMERA_Y_ANGLE_LIMIT 65
 #define PIECE_TAG "PIECE_TAG"
+#define STICKER_NONE 6 //Sticker custom data value of a face without sticker
+#define STICKER_COMPONENT_KEY 63 //Instance component key used by the sticker material, no piece has this face mask
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnCubeChangedSignature, int32, Steps);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnCubeSolvedSignature);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnCubeSavedSignature, bool, bSuccess);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnCubeLoadedSignature, bool, bSuccess);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnCubeGenerationProgressSignature, float, Progress);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnCubeSolveFinishedSignature, bool, bFoundSolution, int32, NumMoves);
 
 UENUM(BlueprintType)
 enum EPieceGroup
@@ -21,7 +33,53 @@ enum EPieceGroup
 	Z UMETA(DisplayName = "Pieces with same Z")
 };
 
+UENUM(BlueprintType)
+enum class EVRubiksPieceBackend : uint8
+{
+	Actors UMETA(DisplayName = "One actor per piece"),
+	Instanced UMETA(DisplayName = "Instanced static meshes"),
+	DynamicMesh UMETA(DisplayName = "One dynamic mesh for the whole cube")
+};
+
+//Where an instanced piece lives: index in PieceInstanceComponents and instance index in that component
+struct FVRubiksPieceInstance
+{
+	int32 Component;
+	int32 Instance;
+};
+
 class AVRubiksPiece;
+class AVRubiksCube;
+class UInstancedStaticMeshComponent;
+class UProceduralMeshComponent;
+struct FStreamableHandle;
+
+//Writes the transforms of the turning pieces once per frame, after every tween of the frame has run
+USTRUCT()
+struct FVRubiksTransformCommitTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	AVRubiksCube* Target;
+
+	FVRubiksTransformCommitTickFunction()
+		: Target(nullptr)
+	{
+	}
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FVRubiksTransformCommitTickFunction> : public TStructOpsTypeTraitsBase2<FVRubiksTransformCommitTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
 
 UCLASS()
 class RUBIKSCUBE_API AVRubiksCube : public APawn
@@ -31,11 +89,141 @@ class RUBIKSCUBE_API AVRubiksCube : public APawn
 	UPROPERTY()
 	TArray <AVRubiksPiece*> Pieces;
 
+	//Indices of the pieces in the slice being rotated
+	TArray <int32> PiecesToRotate;
+
+	//Instanced backend: one component per combination of sticker faces, reused across builds
 	UPROPERTY()
-	TArray <AVRubiksPiece*> PiecesToRotate;
+	TArray <UInstancedStaticMeshComponent*> PieceInstanceComponents;
+
+	//Face mask to index in PieceInstanceComponents
+	TArray <int32> InstanceComponentForFaceMask;
+
+	//Per model piece, where its instance lives
+	TArray <FVRubiksPieceInstance> PieceInstances;
+
+	//Per instance component, the model piece of each instance
+	TArray <TArray <int32>> InstancePieces;
+
+	//Per instance component, the latest transform of each instance and the ones FlushPieceTransforms has yet to upload
+	TArray <TArray <FTransform>> InstanceTransforms;
+	TArray <TBitArray <>> DirtyInstances;
+
+	TBitArray <> DirtyInstanceComponents;
+
+	//Scratch copy of one run of moved instances handed to the instanced mesh
+	TArray <FTransform> DirtyTransforms;
+
+	//Transforms of the rotating pieces relative to the slice pivot, captured when the move starts
+	TArray <FTransform> SliceStartTransforms;
+
+	//Latest rotation of the turning slice, written to the pieces by the commit tick
+	FQuat SliceRotation;
+
+	bool bIsSliceDirty;
+
+	FVRubiksTransformCommitTickFunction TransformCommitTick;
+
+	friend struct FVRubiksTransformCommitTickFunction;
+
+	//Dynamic mesh backend: the vertices of every piece in a single component
+	UPROPERTY()
+	UProceduralMeshComponent * PieceMeshComponent;
+
+	FVRubiksCubeMesh PieceMesh;
+
+	bool bIsPieceMeshDirty;
+
+	UPROPERTY()
+	class UMaterialInstanceDynamic * StickerMaterialInstance;
+
+	//Palette index shown by each face
+	TArray <int32> FacePaletteIndices;
+
+	//LOD the pieces show, and the one they are being switched to a batch per frame
+	EVRubiksPieceLod CurrentLod;
+
+	EVRubiksPieceLod TargetLod;
+
+	//Next piece actor to switch to TargetLod
+	int32 LodSwitchCursor;
+
+	FTimerHandle LodTimerHandle;
+
+	//Faces LOD: one textured quad per face, a texel per sticker
+	UPROPERTY()
+	UProceduralMeshComponent * FaceLodComponent;
 
 	UPROPERTY()
-	AVRubiksPiece * ClickedPiece;
+	TArray <class UTexture2D*> FaceLodTextures;
+
+	UPROPERTY()
+	TArray <class UMaterialInstanceDynamic*> FaceLodMaterialInstances;
+
+	//Size * Size texels per face, face after face, indexed by Row * Size + Col like the sticker cube
+	TArray <FColor> FaceLodTexels;
+
+	//Texels written since the last upload, per face
+	FIntRect FaceLodDirtyRects[6];
+
+	//Cube size the face quads and textures were made for
+	int32 FaceLodSize;
+
+	//Hard references to PieceClass and FaceMaterials, set once they are streamed in
+	UPROPERTY()
+	TSubclassOf<AVRubiksPiece> LoadedPieceClass;
+
+	UPROPERTY()
+	TArray <UMaterialInstance*> LoadedFaceMaterials;
+
+	TSharedPtr<FStreamableHandle> AssetsHandle;
+
+	bool bAreAssetsLoaded;
+
+	//When BeginPlay ran, 0 once the startup timings are logged
+	double StartupSeconds;
+
+	//Restarts left in Rubiks.StartupBenchmark, and the timings of the runs so far
+	int32 StartupBenchmarkRuns;
+
+	TArray <double> StartupAssetsMs;
+
+	TArray <double> StartupInteractiveMs;
+
+	//Backend of the pieces currently generated
+	EVRubiksPieceBackend ActiveBackend;
+
+	//Set by the input events, the pick and gesture run once per frame from Tick
+	bool bIsInteractPending;
+
+	//When the first input sample of the pending frame arrived
+	double InteractInputSeconds;
+
+	//Input time of the turn being started, 0 once its first frame is committed
+	double TurnInputSeconds;
+
+	//Slice following the drag, direction locked to DragDirection until release
+	bool bIsDragTurning;
+
+	//Move the drag turns, QuarterTurns giving the sign of a drag along DragDirection
+	FVRubiksMove DragMove;
+
+	FVector DragDirection;
+
+	//Degrees the slice is turned by the drag
+	float DragAngle;
+
+	//Move the released slice snaps to, no quarter turns when the drag is cancelled
+	FVRubiksMove SnapMove;
+
+	class FCTweenInstance* SnapTween;
+
+	//Tweens this cube is playing, stopped by StopTweens without touching other actors' tweens
+	class FCTweenInstance* IntroTween;
+
+	class FCTweenInstance* TurnTween;
+
+	int32 ClickedPieceIndex;
 	
 	FVector ClickedWorldPosition;
 	
@@ -53,9 +241,76 @@ class RUBIKSCUBE_API AVRubiksCube : public APawn
 	
 	bool bIsScrambling;
 
+	bool bIsGenerating;
+
+	//Set when generation could not create every piece, only a successful build clears it
+	bool bIsIncomplete;
+
+	bool bIsBuildPending;
+
+	//Next model piece to generate while bIsGenerating
+	int32 GenerationCursor;
+
+	float PieceSideWidth;
+
+	TSharedPtr<const FVRubiksCubeLayout> Layout;
+
+	float TimerStartSeconds;
+
+	//Every move committed since the cube was built
+	TArray<FVRubiksMove> History;
+
+	FVRubiksCubeModel Model;
+
+	TUniquePtr<FVRubiksMoveJournal> Journal;
+
+	//Solve running on a worker task, shared with it
+	TSharedPtr<struct FVRubiksSolveJob, ESPMode::ThreadSafe> SolveJob;
+
+	bool bAnimateSolution;
+
+	//Moves of a found solution played one after another, like a scramble
+	TArray<FVRubiksMove> SolutionMoves;
+
+	int32 SolutionCursor;
+
+	bool bIsPlayingSolution;
+
+	//Playback has played every move found so far while the search goes on
+	bool bIsWaitingForSolution;
+
 	UPROPERTY(EditAnywhere, BlueprintGetter=GetSize, BlueprintSetter=SetSize, Category = "Rubiks", meta = (AllowPrivateAccess = "true"))
 	int32 Size;
 
+	//How pieces are rendered, takes effect on the next build that regenerates pieces
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks", meta = (AllowPrivateAccess = "true"))
+	EVRubiksPieceBackend PieceBackend;
+
+	//Time spent generating pieces per frame, the rest of the cube is generated on the next frames
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks", meta = (AllowPrivateAccess = "true", ClampMin = "0.1", Units = "ms"))
+	float GenerationBudgetMs;
+
+	//Length of the snap to the nearest quarter turn once a dragged slice is released
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks", meta = (AllowPrivateAccess = "true", ClampMin = "0.01", Units = "s"))
+	float SnapDuration;
+
+	//Drag length, in piece widths, that turns a slice by 90 degrees
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks", meta = (AllowPrivateAccess = "true", ClampMin = "0.1"))
+	float DragPiecesPerQuarterTurn;
+
+	//Longest a solve searches for a shorter solution, the best one found by then is used. Bigger cubes only spend it on
+	//their last (3x3) stage, the reduction before it always runs to the end unless cancelled
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks", meta = (AllowPrivateAccess = "true", ClampMin = "0.01", Units = "s"))
+	float SolveTimeBudget;
+
+	//Length of each move when a solution is played
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks", meta = (AllowPrivateAccess = "true", ClampMin = "0.01", Units = "s"))
+	float SolutionMoveDuration;
+
+	//Keeps a journal of the committed moves in Saved/Rubiks so the session survives a crash
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Rubiks", meta = (AllowPrivateAccess = "true"))
+	bool bEnableMoveJournal;
+
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Rubiks", meta = (AllowPrivateAccess = "true"))
 	class UInputMappingContext* DefaultMappingContext;
 
@@ -65,6 +320,7 @@ class RUBIKSCUBE_API AVRubiksCube : public APawn
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Rubiks", meta = (AllowPrivateAccess = "true"))
 	class USceneComponent * DummySceneComponent;
 
+	//Marks the slice pivot at the cube center, slices are turned by transform math and never attached to it
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Rubiks", meta = (AllowPrivateAccess = "true"))
 	class USceneComponent * RotatorSceneComponent;
     
@@ -78,18 +334,157 @@ class RUBIKSCUBE_API AVRubiksCube : public APawn
 	
 	void DestroyPieces();
 	
+	//Starts generating the pieces, spread over the next frames by GenerateNextPieces
 	void GeneratePieces();
+
+	void GenerateNextPieces();
+
+	//Stops generating and leaves the cube inert until the next build completes
+	void AbortGeneration();
+
+	//Instanced backend: adds every piece as an instance in one batch per component
+	void GenerateInstances();
+
+	UInstancedStaticMeshComponent* GetInstanceComponent(uint8 FaceMask, int32& OutComponentIndex);
+
+	//Dynamic mesh backend: builds the whole cube mesh in one go
+	void GeneratePieceMesh();
+
+	FColor GetFaceColor(int32 Face) const;
+
+	int32 GetNumGeneratedPieces() const;
+
+	//Intersects a world space ray with the cube's box and returns the piece in the cell it enters, pieces need no collision
+	bool PickPiece(const FVector& RayOrigin, const FVector& RayDirection, int32& OutPieceIndex, FVector& OutWorldPosition, FVector& OutWorldNormal) const;
+
+	FTransform GetPieceModelTransform(int32 PieceIndex) const;
+
+	//Sets the transform of a piece relative to the cube, instances and the dynamic mesh only get it in FlushPieceTransforms
+	void SetPieceTransform(int32 PieceIndex, const FTransform& RelativeTransform);
+
+	void SnapPieceToModel(int32 PieceIndex);
+
+	void FlushPieceTransforms();
+
+	void UpdateInstanceRange(int32 ComponentIndex, int32 FirstInstance, int32 LastInstance);
+
+	//Commit stage: one pass over every turning piece, render state updates only dirtied once at the end
+	void CommitPieceTransforms();
+
+	void FinishGeneration();
+
+	void PlayIntroAnimation();
+
+	void StopTweens();
+
+	//Drops the pieces and the streamed assets and starts over as BeginPlay does, for Rubiks.StartupBenchmark
+	void RestartStartup();
+
+	void LogStartupBenchmark();
+
+	//Streams PieceClass and FaceMaterials in, the cube is built from OnAssetsLoaded
+	void RequestAssets();
+
+	void OnAssetsLoaded();
+
+	void UpdateTickEnabled();
+
+	//Resets the logical model to solved and syncs the existing pieces to it
+	void ResetPieces();
 	
-	void UpdatePieceMaterials(AVRubiksPiece* Piece, int32 X, int32 Y, int32 Z);
+	void UpdatePieceMaterials(AVRubiksPiece* Piece, uint8 FaceMask);
+
+	bool UsesStickerCustomData() const;
+
+	class UMaterialInstanceDynamic* GetStickerMaterialInstance();
+
+	float GetStickerValue(uint8 FaceMask, int32 Face) const;
+
+	//Writes the palette index of each face of the piece into its custom data
+	void WritePieceStickerData(int32 PieceIndex);
 	
-	void RotateFromPiece(AVRubiksPiece * Piece, FVector Normal, FVector Direction);
+	//Pick, drag detection and camera movement for the input samples of this frame
+	void ProcessInteract();
+
+	//Where the mouse ray crosses the plane of the clicked face
+	bool GetDragPosition(const FVector& RayOrigin, const FVector& RayDirection, FVector& OutPosition) const;
+
+	void BeginDragTurn(const FVector& Direction);
+
+	void UpdateDragTurn(const FVector& DragPosition);
+
+	//Snaps the released slice to the nearest quarter turn with a short tween
+	void EndDragTurn();
+
+	//Lands a snapping slice right away
+	void FinishSnap();
+
+	void CompleteDragTurn();
+
+	bool GetMoveFromDrag(int32 PieceIndex, FVector Normal, FVector Direction, FVRubiksMove& OutMove) const;
 	
-	void RotateGroup(AVRubiksPiece * Piece, EPieceGroup GroupAxis, FRotator Rotation, float Speed = 0.4f);
+	bool GetGroupMove(int32 PieceIndex, EPieceGroup GroupAxis, FRotator Rotation, FVRubiksMove& OutMove) const;
+
+	//Captures the slice's pieces relative to the pivot and starts the commit tick
+	void BeginSliceTurn(const FVRubiksMove& Move);
+
+	void RotateMove(const FVRubiksMove& Move, float Speed);
+
+	void CommitMove(const FVRubiksMove& Move, bool bCountsAsStep);
+
+	//Takes the moves the solve found so far, and its result once its task is done
+	void PollSolve();
+
+	void PlayNextSolutionMove();
+
+	//Places every piece at the cell and orientation the logical model holds for it
+	void SyncPiecesToModel();
+
+	//Replaces the logical model, rebuilding only if the size changed
+	void RestoreModel(const FVRubiksCubeModel& NewModel, int32 NewSteps);
+
+	void ResetTimer(float ElapsedTime = 0.0f);
+
+	//Picks the LOD from the screen size of a piece, run every LodUpdateInterval
+	void UpdateLod();
+
+	//Closest level this cube can show: missing assets or backends without it fall back to a finer one
+	EVRubiksPieceLod GetSupportedLod(EVRubiksPieceLod Lod) const;
+
+	void BeginLodSwitch(EVRubiksPieceLod Lod);
+
+	//Switches the next LodSwitchBatchSize piece actors, the other backends switch per component in BeginLodSwitch
+	void SwitchNextPieces();
+
+	void FinishLodSwitch();
+
+	void SetPieceActorLod(AVRubiksPiece* Piece, EVRubiksPieceLod Lod);
+
+	//Back to the full pieces right away, before they are pooled or rebuilt
+	void ResetLod();
+
+	bool IsFaceLodActive() const;
+
+	//Rewrites every face texel from the model
+	void BuildFaceLod();
+
+	//Writes the texels of the stickers the piece shows at its current cell
+	void WriteFaceLodPiece(int32 PieceIndex);
+
+	void UploadFaceLodTexels();
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void Tick(float DeltaSeconds) override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
 	virtual void SetupPlayerInputComponent(UInputComponent* PlayerInputComponent) override;
 
 public:
@@ -99,16 +494,78 @@ public:
 	
 	UPROPERTY(BlueprintAssignable, Category = "Rubiks")
 	FOnCubeSolvedSignature OnCubeSolved;
+
+	//Fraction of the pieces generated so far, 1 once the cube is complete and interactive
+	UPROPERTY(BlueprintAssignable, Category = "Rubiks")
+	FOnCubeGenerationProgressSignature OnCubeGenerationProgress;
+
+	UPROPERTY(BlueprintAssignable, Category = "Rubiks")
+	FOnCubeSavedSignature OnCubeSaved;
+
+	UPROPERTY(BlueprintAssignable, Category = "Rubiks")
+	FOnCubeLoadedSignature OnCubeLoaded;
+
+	//Fires once a solve started by SolveCube has finished searching. On bigger cubes the moves of the first stages may
+	//already be played or applied by then. Those moves are never undone: when a later stage fails they still play out
+	//and NumMoves counts them, when the solve is cancelled NumMoves counts the moves applied or already turning
+	UPROPERTY(BlueprintAssignable, Category = "Rubiks")
+	FOnCubeSolveFinishedSignature OnCubeSolveFinished;
 	
+	//Soft references, loaded asynchronously when play begins so the map does not wait for them
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks")
+	TSoftClassPtr<AVRubiksPiece> PieceClass;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks")
+	TArray<TSoftObjectPtr<UMaterialInstance>> FaceMaterials;
+
+	/**
+	 * Optional shared sticker material. When set it replaces FaceMaterials on every sticker slot: face N reads custom data N
+	 * (per instance or per primitive) as an index into the PaletteColor0..5 parameters, 6 meaning no sticker.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks")
+	UMaterialInterface* StickerMaterial;
+
+	//Palette used by StickerMaterial and by the dynamic mesh backend, change it through SetColorScheme
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks")
+	TArray<FLinearColor> FaceColors;
+
+	//Optional palette shared by every cube whose sticker material reads PaletteColor0..5 from this collection
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks")
+	class UMaterialParameterCollection* PaletteCollection;
+
+	//Material of the dynamic mesh backend, sticker colors come in as vertex colors
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks")
+	UMaterialInterface* PieceMeshMaterial;
+
+	//Screen sizes at which the pieces drop to cheaper representations
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks")
+	FVRubiksLodPolicy LodPolicy;
+
+	//Stickers LOD mesh: a flat quad per face with the material slots of the piece mesh, the level is skipped when unset
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks")
-	TSubclassOf<AVRubiksPiece> PieceClass;
+	UStaticMesh* StickerLodMesh;
 
+	//Faces LOD material, reads its face from the "Stickers" texture like the sticker cube; the level is skipped when unset
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks")
-	TArray<UMaterialInstance*> FaceMaterials;
+	UMaterialInterface* FaceLodMaterial;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks", meta = (ClampMin = "0.05", Units = "s"))
+	float LodUpdateInterval;
+
+	//Piece actors switched per frame when the LOD changes
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks", meta = (ClampMin = "1"))
+	int32 LodSwitchBatchSize;
+
+	//Pieces spawned into the world's piece pool at startup, 1352 covers a 16x16 cube
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks", meta = (ClampMin = "0"))
+	int32 PoolPrewarmCount;
 	
 	// Sets default values for this actor's properties
 	AVRubiksCube();
 
+	//Restarts the cube from its assets Runs times, then logs how long the assets and the interactive cube took
+	void BenchmarkStartup(int32 Runs);
+
 	UFUNCTION(BlueprintSetter, Category = "Rubiks")
 	void SetSize(int32 NewSize);
 	
@@ -117,16 +574,79 @@ public:
 	
 	UFUNCTION(BlueprintCallable, Category = "Rubiks")
 	void Build();
+
+	//Marks the cube for a rebuild on the next tick, any number of requests in a frame cost one Build
+	UFUNCTION(BlueprintCallable, Category = "Rubiks")
+	void RequestBuild();
+
+	UFUNCTION(BlueprintPure, Category = "Rubiks")
+	bool IsBuildPending();
 	
+	//Ignored while the cube is busy or a build requested by SetSize is still pending (see IsBuildPending)
 	UFUNCTION(BlueprintCallable, Category = "Rubiks")
 	void Scramble(int32 TotalSteps);
 
 	UFUNCTION(BlueprintPure, Category = "Rubiks")
 	int32 GetSteps();
 
+	//Searches a solution on a worker task (2x2 optimal, 3x3 near optimal, bigger cubes by reduction), then plays its moves
+	//or applies them all at once. Bigger cubes start with the first stages while the next ones are searched. Ignored while
+	//the cube is busy or a build is still pending
+	UFUNCTION(BlueprintCallable, Category = "Rubiks")
+	void SolveCube(bool bAnimate = true);
+
+	//Stops the running search, or the played solution after its current move. Moves already applied stay on the cube
+	UFUNCTION(BlueprintCallable, Category = "Rubiks")
+	void CancelSolve();
+
+	//True while a solution is searched or played
+	UFUNCTION(BlueprintPure, Category = "Rubiks")
+	bool IsSolving();
+
 	UFUNCTION(BlueprintPure, Category = "Rubiks")
 	bool IsCubeSolved();
 
+	//Fewest moves that solve a 2x2, cheap enough to show after every move. -1 for other sizes or while the table loads
+	UFUNCTION(BlueprintPure, Category = "Rubiks")
+	int32 GetMovesToSolve();
+
+	UFUNCTION(BlueprintPure, Category = "Rubiks")
+	bool IsGenerating();
+
+	//True after a generation was aborted, the cube ignores input, scramble, solve and load until it is rebuilt
+	UFUNCTION(BlueprintPure, Category = "Rubiks")
+	bool IsIncomplete();
+
+	//False while the piece class and face materials are still streaming in
+	UFUNCTION(BlueprintPure, Category = "Rubiks")
+	bool AreAssetsLoaded();
+
+	UFUNCTION(BlueprintPure, Category = "Rubiks")
+	EVRubiksPieceLod GetPieceLod();
+
+	//Shows palette color PaletteIndex on Face (Front, Back, Left, Right, Up, Down), needs StickerMaterial or the dynamic mesh backend
+	UFUNCTION(BlueprintCallable, Category = "Rubiks")
+	void SetFacePaletteIndex(int32 Face, int32 PaletteIndex);
+
+	//Recolors every sticker without touching the pieces, through the palette collection and the sticker material
+	UFUNCTION(BlueprintCallable, Category = "Rubiks")
+	void SetColorScheme(const TArray<FLinearColor>& Colors);
+
+	UFUNCTION(BlueprintCallable, Category = "Rubiks")
+	void SetColorSchemePreset(EVRubiksColorScheme Scheme);
+
+	//Seconds since the cube was built or scrambled
+	UFUNCTION(BlueprintPure, Category = "Rubiks")
+	float GetElapsedTime();
+
+	//Saves size, state, history and timer asynchronously, OnCubeSaved fires when done
+	UFUNCTION(BlueprintCallable, Category = "Rubiks")
+	void SaveCube(const FString& SlotName, int32 UserIndex = 0);
+
+	//Loads a cube saved with SaveCube asynchronously, OnCubeLoaded fires when done
+	UFUNCTION(BlueprintCallable, Category = "Rubiks")
+	void LoadCube(const FString& SlotName, int32 UserIndex = 0);
+
 	//Input functions
 
 	UFUNCTION()
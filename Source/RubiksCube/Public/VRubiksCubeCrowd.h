@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "VRubiksCubeModel.h"
+#include "VRubiksCubeCrowd.generated.h"
+
+class AVRubiksPiece;
+class UInstancedStaticMeshComponent;
+class UMaterialInstanceDynamic;
+
+/**
+ * The 27 moves of a 3x3 cube (3 axes, 3 layers, turns of +1, -1 and 2) as slot permutations, built once and shared by
+ * every crowd cube. Slots follow the piece order of FVRubiksCubeModel.
+ */
+struct RUBIKSCUBE_API FVRubiksCrowdMoveTable
+{
+	static constexpr int32 NumPieces = 26;
+	static constexpr int32 NumMoves = 27;
+
+	FVRubiksMove Moves[NumMoves];
+
+	//Rotation axis and angle of each move, so eased angles can overshoot
+	FVector MoveAxes[NumMoves];
+	float MoveAngles[NumMoves];
+
+	//Slots in the slice of each move (9, or 8 for a middle layer)
+	uint8 SliceSlots[NumMoves][9];
+	uint8 SliceSizes[NumMoves];
+
+	//Slot a piece ends up in after the move
+	uint8 SlotAfter[NumMoves][NumPieces];
+
+	FIntVector SlotCells[NumPieces];
+
+	uint8 SlotFaceMasks[NumPieces];
+
+	static const FVRubiksCrowdMoveTable& Get();
+
+private:
+	FVRubiksCrowdMoveTable();
+};
+
+/**
+ * Many 3x3 cubes playing random moves, advanced together in one pass with no UObject involved, so it also runs headless.
+ * Piece P of cube N is instance N * 26 + P.
+ */
+class RUBIKSCUBE_API FVRubiksCrowdSimulation
+{
+public:
+	FVRubiksCrowdSimulation();
+
+	//Lays out NumCubes solved cubes on a grid of Columns, Spacing apart (in cube widths)
+	void Reset(int32 NumCubes, int32 Columns, float PieceWidth, float Spacing, int32 Seed);
+
+	//Advances every cube and reports the range of instances whose transform changed, OutFirstDirty > OutLastDirty when none did
+	void Tick(float DeltaSeconds, int32& OutFirstDirty, int32& OutLastDirty);
+
+	const TArray<FTransform>& GetTransforms() const { return Transforms; }
+
+	int32 NumCubes() const { return Cubes.Num(); }
+
+	float MoveDuration;
+
+	//Idle time before the next move is picked at random up to this
+	float MaxIdleTime;
+
+private:
+	struct FCube
+	{
+		uint8 SlotPieces[FVRubiksCrowdMoveTable::NumPieces];
+		uint8 Orientations[FVRubiksCrowdMoveTable::NumPieces];
+		int32 Move;
+		//Time in the current move, negative while idle
+		float Time;
+		FVector Origin;
+	};
+
+	TArray<FCube> Cubes;
+
+	TArray<FTransform> Transforms;
+
+	float PieceWidth;
+
+	FRandomStream Random;
+
+	void SetPieceTransform(const FCube& Cube, int32 CubeIndex, int32 Slot, const FQuat& SliceRotation);
+};
+
+/**
+ * Shows a crowd of idle 3x3 cubes through a single instanced mesh: one tick, one transform batch and one render state
+ * update per frame for all of them. The crowd has no camera or input, the player's AVRubiksCube keeps those.
+ * Stickers use the same StickerMaterial contract as AVRubiksCube (per instance custom data, PaletteColor0..5).
+ */
+UCLASS()
+class RUBIKSCUBE_API AVRubiksCubeCrowd : public AActor
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Rubiks", meta = (AllowPrivateAccess = "true"))
+	UInstancedStaticMeshComponent * PieceInstances;
+
+	UPROPERTY()
+	UMaterialInstanceDynamic * StickerMaterialInstance;
+
+	FVRubiksCrowdSimulation Simulation;
+
+	//Scratch copy of the dirty transform range handed to the instanced mesh
+	TArray<FTransform> DirtyTransforms;
+
+protected:
+	virtual void BeginPlay() override;
+
+	virtual void Tick(float DeltaSeconds) override;
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Rubiks", meta = (ClampMin = "1"))
+	int32 NumCubes;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Rubiks", meta = (ClampMin = "1"))
+	int32 Columns;
+
+	//Distance between cube origins, in cube widths
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Rubiks", meta = (ClampMin = "1.0"))
+	float Spacing;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Rubiks", meta = (ClampMin = "0.01", Units = "s"))
+	float MoveDuration;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Rubiks", meta = (ClampMin = "0.0", Units = "s"))
+	float MaxIdleTime;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Rubiks")
+	TSubclassOf<AVRubiksPiece> PieceClass;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Rubiks")
+	UMaterialInterface* StickerMaterial;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Rubiks")
+	TArray<FLinearColor> FaceColors;
+
+	AVRubiksCubeCrowd();
+
+	//Rebuilds the crowd with the current settings
+	UFUNCTION(BlueprintCallable, Category = "Rubiks")
+	void Build();
+};
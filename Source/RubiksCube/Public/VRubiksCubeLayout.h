@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UStaticMesh;
+
+/**
+ * Everything needed to place the pieces of a cube of a given size and piece mesh: only the surface cells, in model order,
+ * with their offsets from the cube origin and which faces show a sticker.
+ * Built once per (size, mesh) and shared by every cube through Get().
+ */
+struct RUBIKSCUBE_API FVRubiksCubeLayout
+{
+	//Face bits, same order as the piece material slots and FaceMaterials
+	enum EFace : uint8
+	{
+		Front = 1 << 0, //X == 0
+		Back = 1 << 1, //X == Size - 1
+		Left = 1 << 2, //Y == 0
+		Right = 1 << 3, //Y == Size - 1
+		Up = 1 << 4, //Z == Size - 1
+		Down = 1 << 5 //Z == 0
+	};
+
+	int32 Size;
+
+	float PieceWidth;
+
+	//Pivot of the cube (and of every slice) relative to the cube origin
+	FVector Center;
+
+	TArray<FIntVector> Cells;
+
+	TArray<FVector> Offsets;
+
+	TArray<uint8> FaceMasks;
+
+	static uint8 GetFaceMask(const FIntVector& Cell, int32 CubeSize);
+
+	//Width of the piece mesh, read from its bounds
+	static float GetPieceWidth(const UStaticMesh* PieceMesh);
+
+	static TSharedRef<const FVRubiksCubeLayout> Get(int32 CubeSize, const UStaticMesh* PieceMesh);
+};
@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FVRubiksCubeLayout;
+
+/**
+ * CPU side geometry of a whole cube as one mesh: every piece is a box of 24 vertices (4 per face), stored contiguously in
+ * model order, so moving a piece only rewrites its own vertex range.
+ */
+struct RUBIKSCUBE_API FVRubiksCubeMesh
+{
+	static constexpr int32 VerticesPerPiece = 24;
+
+	TArray<FVector> Vertices;
+
+	TArray<FVector> Normals;
+
+	TArray<FVector2D> UVs;
+
+	TArray<FColor> Colors;
+
+	TArray<int32> Triangles;
+
+	//Builds the solved cube, faces with a sticker get their FaceColors entry and the others InnerColor
+	void Build(const FVRubiksCubeLayout& Layout, const FColor (&FaceColors)[6], const FColor& InnerColor);
+
+	void Reset();
+
+	int32 NumPieces() const;
+
+	//Places the vertices of a piece, Transform is relative to the cube like the piece actors
+	void SetPieceTransform(int32 PieceIndex, const FTransform& Transform);
+
+	void SetFaceColor(int32 PieceIndex, int32 Face, const FColor& Color);
+
+private:
+	//The 24 vertices and normals of one piece around its own origin
+	FVector LocalVertices[VerticesPerPiece];
+
+	FVector LocalNormals[VerticesPerPiece];
+};
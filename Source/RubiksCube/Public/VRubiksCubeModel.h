@@ -0,0 +1,138 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * A single slice turn: every piece whose grid coordinate on Axis equals Layer is rotated by
+ * QuarterTurns * 90 degrees. Axis uses the same values as EPieceGroup (0 = X, 1 = Y, 2 = Z).
+ */
+struct RUBIKSCUBE_API FVRubiksMove
+{
+	uint8 Axis;
+
+	uint16 Layer;
+
+	int8 QuarterTurns;
+
+	FVRubiksMove()
+		: Axis(0), Layer(0), QuarterTurns(1)
+	{
+	}
+
+	FVRubiksMove(int32 InAxis, int32 InLayer, int32 InQuarterTurns)
+		: Axis((uint8)InAxis), Layer((uint16)InLayer), QuarterTurns((int8)InQuarterTurns)
+	{
+	}
+
+	//Rotation applied to the slice, matching the rotators the cube has always used for each group
+	FQuat GetRotation() const;
+
+	//Same rotation for any angle, used while a slice follows the mouse
+	static FQuat GetAxisRotation(int32 Axis, float Degrees);
+
+	FVRubiksMove Inverse() const;
+
+	//Packs the move in 15 bits (layer 11 bits, axis 2 bits, turn 2 bits), the top bit is left free for the caller
+	uint16 Pack() const;
+
+	static bool Unpack(uint16 Packed, FVRubiksMove& OutMove);
+
+	bool operator==(const FVRubiksMove& Other) const
+	{
+		return Axis == Other.Axis && Layer == Other.Layer && QuarterTurns == Other.QuarterTurns;
+	}
+};
+
+/**
+ * Logical model of the cube, independent of any actor or component.
+ * Every surface piece keeps its solved (home) cell, its current cell and its orientation as one of the 24 cube rotations.
+ * Pieces are enumerated in the same order AVRubiksCube has always spawned them, so piece N of the model is piece N of the cube.
+ */
+class RUBIKSCUBE_API FVRubiksCubeModel
+{
+public:
+	struct FPiece
+	{
+		FIntVector HomeCell;
+		FIntVector Cell;
+		uint8 Orientation;
+	};
+
+	FVRubiksCubeModel();
+
+	//Resets to a solved cube of the given size
+	void Reset(int32 NewSize);
+
+	//Puts every piece back in its home cell without touching the size
+	void ResetToSolved();
+
+	int32 GetSize() const { return Size; }
+
+	int32 NumPieces() const { return Pieces.Num(); }
+
+	const FPiece& GetPiece(int32 Index) const { return Pieces[Index]; }
+
+	//Rotation of the piece relative to its solved orientation
+	FQuat GetPieceRotation(int32 Index) const;
+
+	bool IsValidMove(const FVRubiksMove& Move) const;
+
+	void ApplyMove(const FVRubiksMove& Move);
+
+	//Piece currently at the cell, INDEX_NONE for interior or out of range cells
+	int32 GetPieceAtCell(const FIntVector& Cell) const;
+
+	//Collects the indices of the pieces currently in the move's slice
+	void GetSlicePieces(const FVRubiksMove& Move, TArray<int32>& OutPieces) const;
+
+	//True when every face of the cube shows a single color. Spins of center pieces and swaps of same colored centers do not
+	//show, so they are not required, the cube may also sit in any overall orientation
+	bool IsSolved() const;
+
+	//Compact binary layout: size, then per piece its current surface slot and orientation (3 bytes per piece)
+	void Save(FArchive& Ar) const;
+
+	//Returns false, leaving a solved cube, when the data does not describe a valid cube
+	bool Load(FArchive& Ar);
+
+	static int32 NumOrientations() { return 24; }
+
+	static const FQuat& GetOrientationQuat(uint8 Orientation);
+
+	//Orientation of a piece in Orientation after the move turns it
+	static uint8 TurnOrientation(uint8 Orientation, const FVRubiksMove& Move);
+
+	//Exact integer rotation of a vector by a move's quarter turns around Axis, same rotation as FVRubiksMove::GetRotation
+	static FIntVector RotateVector(const FIntVector& Vector, int32 Axis, int32 QuarterTurns);
+
+	//Exact integer rotation of a vector by one of the 24 orientations
+	static FIntVector RotateByOrientation(uint8 Orientation, const FIntVector& Vector);
+
+	static uint8 InverseOrientation(uint8 Orientation);
+
+	//A move written in a frame turned by Frame, as the same turn in the model's frame. Solvers work in a fixed frame and
+	//use this to map their moves back onto a cube that has been turned as a whole
+	static FVRubiksMove ReorientMove(const FVRubiksMove& Move, uint8 Frame, int32 CubeSize);
+
+	static bool IsSurfaceCell(const FIntVector& Cell, int32 CubeSize);
+
+	//Surface cells in piece order, visiting only the cells that belong to a wall
+	static void GetSurfaceCells(int32 CubeSize, TArray<FIntVector>& OutCells);
+
+private:
+	int32 Size;
+
+	TArray<FPiece> Pieces;
+
+	//Cell index (X + Size * (Y + Size * Z)) to surface slot, -1 for interior cells
+	TArray<int32> CellToSlot;
+
+	TArray<FIntVector> SlotToCell;
+
+	//Cell index to the piece currently there, kept up to date by every move
+	TArray<int32> CellToPiece;
+
+	void BuildSlots();
+};
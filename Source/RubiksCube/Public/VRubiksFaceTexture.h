@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UTexture2D;
+
+/**
+ * One texel per sticker textures of a cube face, shared by the face LOD of AVRubiksCube and by AVRubiksStickerCube.
+ * Only the rectangle of stickers that changed is uploaded.
+ */
+struct RUBIKSCUBE_API FVRubiksFaceTexture
+{
+	//Size x Size, sampled without filtering so every texel stays a sharp sticker
+	static UTexture2D* Create(int32 Size);
+
+	//Copies the texels of Rect, GetTexel taking texel coordinates, the render thread frees the copy once it is uploaded
+	static void UploadRect(UTexture2D* Texture, const FIntRect& Rect, TFunctionRef<FColor(int32 X, int32 Y)> GetTexel);
+};
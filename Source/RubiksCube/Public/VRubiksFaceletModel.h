@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VRubiksCubeModel.h"
+
+/**
+ * Sticker-only model of a cube, for sizes far beyond what a per-piece model can handle.
+ * Each face is a Size x Size grid of sticker colors (the index of the face the sticker belongs to when solved).
+ * Faces use the layout face order (Front, Back, Left, Right, Up, Down) and are addressed in cube coordinates:
+ * a face whose normal is on axis A has its columns on axis (A + 1) % 3 and its rows on axis (A + 2) % 3.
+ *
+ * A move only rewrites the band of 4 * Size stickers it carries around. Turning a whole face (outer layers) only changes
+ * the face's storage rotation, so every move costs O(Size) whatever the layer.
+ */
+class RUBIKSCUBE_API FVRubiksFaceletModel
+{
+public:
+	FVRubiksFaceletModel();
+
+	//Resets to a solved cube of the given size
+	void Reset(int32 NewSize);
+
+	//Takes the size and every sticker of a piece model, so solvers can work on stickers
+	void SetFromModel(const FVRubiksCubeModel& Model);
+
+	int32 GetSize() const { return Size; }
+
+	uint8 GetSticker(int32 Face, int32 Col, int32 Row) const;
+
+	bool IsValidMove(const FVRubiksMove& Move) const;
+
+	void ApplyMove(const FVRubiksMove& Move);
+
+	//True when every face shows a single color
+	bool IsSolved() const;
+
+	//Face stickers as stored, Size * Size bytes indexed by Row * Size + Col in storage space
+	const TArray<uint8>& GetFaceData(int32 Face) const { return Faces[Face]; }
+
+	//Quarter turns from cube coordinates to storage space: storage = rotation of -FaceRotation around the face center
+	int32 GetFaceRotation(int32 Face) const { return FaceRotations[Face]; }
+
+	//Storage space rect of the stickers the move carries on Face, empty when Face is not part of the move's band
+	FIntRect GetBandRect(int32 Face, const FVRubiksMove& Move) const;
+
+	static int32 GetFace(int32 Axis, bool bPositive);
+
+	static int32 GetFaceAxis(int32 Face);
+
+	static bool IsFacePositive(int32 Face);
+
+	//Cube axes along the columns and rows of a face
+	static void GetFaceAxes(int32 Face, int32& OutColAxis, int32& OutRowAxis);
+
+private:
+	int32 Size;
+
+	TArray<uint8> Faces[6];
+
+	int32 FaceRotations[6];
+
+	//Scratch buffer for the band of the move being applied
+	TArray<uint8> BandColors;
+
+	FIntPoint GetStoragePoint(int32 Face, int32 Col, int32 Row) const;
+
+	void SetSticker(int32 Face, int32 Col, int32 Row, uint8 Color);
+
+	//Cell of the band sticker T (0 to Size - 1) on Face for the move
+	FIntVector GetBandCell(int32 Face, const FVRubiksMove& Move, int32 T) const;
+};
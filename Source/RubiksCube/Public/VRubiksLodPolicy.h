@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VRubiksLodPolicy.generated.h"
+
+//How the pieces of a cube are drawn, from the most to the least detailed
+UENUM(BlueprintType)
+enum class EVRubiksPieceLod : uint8
+{
+	Full UMETA(DisplayName = "Full piece mesh"),
+	Stickers UMETA(DisplayName = "Flat quad per sticker"),
+	Faces UMETA(DisplayName = "One texture per face")
+};
+
+/**
+ * Picks the representation of a cube's pieces from the screen size of one piece (its projected width over the viewport
+ * width). A coarser level starts below its threshold, a finer one only comes back once the piece is Hysteresis above it,
+ * so a cube sitting on a threshold does not flip every update.
+ * Pure function of its inputs, checked by the Rubiks.LodPolicy.Select automation test. Rubiks.LodTable prints what it
+ * picks at each screen size.
+ */
+USTRUCT(BlueprintType)
+struct RUBIKSCUBE_API FVRubiksLodPolicy
+{
+	GENERATED_BODY()
+
+	//Below this screen size pieces are drawn as flat sticker quads
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks", meta = (ClampMin = "0"))
+	float StickersScreenSize;
+
+	//Below this screen size each face of the cube is drawn as a single textured quad
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks", meta = (ClampMin = "0"))
+	float FacesScreenSize;
+
+	//Fraction above a threshold a piece must grow before going back to the finer level
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks", meta = (ClampMin = "0"))
+	float Hysteresis;
+
+	FVRubiksLodPolicy();
+
+	EVRubiksPieceLod Select(float PieceScreenSize, EVRubiksPieceLod CurrentLod) const;
+
+	//Projected width of a piece at Distance over the viewport width, FOVDegrees being the horizontal field of view
+	static float GetPieceScreenSize(float PieceWidth, float Distance, float FOVDegrees);
+};
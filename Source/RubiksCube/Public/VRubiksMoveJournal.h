@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Tasks/Pipe.h"
+
+struct FVRubiksMove;
+class FVRubiksCubeModel;
+class IFileHandle;
+
+/**
+ * Crash-safe, append-only record of the committed moves of a cube.
+ * Moves are buffered on the game thread and written in batches by a serial background pipe, so the game thread never touches the disk
+ * after startup. Once enough moves accumulate the journal is compacted: the current model is written as a snapshot and the journal is
+ * restarted, which keeps both files (and the cost of recovering them) bounded.
+ */
+class RUBIKSCUBE_API FVRubiksMoveJournal
+{
+public:
+	//Moves buffered before a batch is handed to the writer
+	static constexpr int32 BatchSize = 16;
+
+	//Pending moves are flushed at least this often, even if the batch is not full
+	static constexpr float FlushIntervalSeconds = 0.5f;
+
+	//Journal entries after which the owner should compact to a new snapshot
+	static constexpr int32 CompactionThreshold = 256;
+
+	FVRubiksMoveJournal(const FString& InDirectory, const FString& InName);
+
+	~FVRubiksMoveJournal();
+
+	/**
+	 * Reads the last snapshot and replays the journal tail on top of it. Only meant to be called once at startup,
+	 * before any move is appended. Returns false when there is nothing (valid) to recover.
+	 */
+	bool Recover(FVRubiksCubeModel& OutModel, int32& OutSteps);
+
+	//Records a committed move, bCountsAsStep marks the moves made by the player
+	void Append(const FVRubiksMove& Move, bool bCountsAsStep);
+
+	bool NeedsCompaction() const { return EntriesSinceSnapshot >= CompactionThreshold; }
+
+	//Writes Model as the new snapshot and restarts the journal from it
+	void Compact(const FVRubiksCubeModel& Model, int32 Steps);
+
+	//Hands the buffered moves to the writer
+	void Flush();
+
+private:
+	FString SnapshotPath;
+
+	//Where the previous snapshot waits while a compaction swaps the new one in
+	FString OldSnapshotPath;
+
+	FString JournalPath;
+
+	uint32 Generation;
+
+	int32 EntriesSinceSnapshot;
+
+	TArray<uint16> PendingEntries;
+
+	//Only touched from tasks running on WriterPipe
+	TUniquePtr<IFileHandle> JournalHandle;
+
+	UE::Tasks::FPipe WriterPipe;
+
+	UE::Tasks::FTask LastWrite;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+
+	bool Tick(float DeltaTime);
+};
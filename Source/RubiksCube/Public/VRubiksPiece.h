@@ -23,7 +23,21 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Rubiks")
 	void SetFaceMaterial(int32 Index, UMaterialInstance* Material);
 
+	//Drops every face material, back to the materials of the class defaults (the Blueprint's overrides, if any)
+	UFUNCTION(BlueprintCallable, Category = "Rubiks")
+	void ResetFaceMaterials();
+
+	//Custom primitive data read by the shared sticker material
+	void SetStickerData(int32 Face, float Value);
+
+	//Hides and detaches the piece while it waits in the pool, its face materials reset
+	void SetPooled(bool bPooled);
+
 	UFUNCTION(BlueprintPure, Category = "Rubiks")
-	float GetSideWidth();
+	float GetSideWidth() const;
+
+	UStaticMesh* GetStaticMesh() const;
+
+	UStaticMeshComponent* GetMeshComponent() const;
 	
 };
@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "VRubiksPiecePool.generated.h"
+
+class AVRubiksPiece;
+
+USTRUCT()
+struct FVRubiksPieceList
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<AVRubiksPiece*> Pieces;
+};
+
+/**
+ * Hidden, deactivated piece actors kept alive between cube builds, so a size change only spawns (or parks) the difference
+ * in piece count. Shared by every cube of the world.
+ */
+UCLASS()
+class RUBIKSCUBE_API UVRubiksPiecePool : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+	//Free pieces per piece class
+	UPROPERTY()
+	TMap<UClass*, FVRubiksPieceList> FreePieces;
+
+	AVRubiksPiece* SpawnPiece(TSubclassOf<AVRubiksPiece> PieceClass);
+
+public:
+	//Takes a free piece of the given class, spawning one only when the pool is empty
+	AVRubiksPiece* Acquire(TSubclassOf<AVRubiksPiece> PieceClass, AActor* Owner);
+
+	//Hides and deactivates the piece and keeps it for the next Acquire
+	void Release(AVRubiksPiece* Piece);
+
+	//Spawns pieces until at least Count free pieces of the class are available
+	UFUNCTION(BlueprintCallable, Category = "Rubiks")
+	void Prewarm(TSubclassOf<AVRubiksPiece> PieceClass, int32 Count);
+
+	UFUNCTION(BlueprintPure, Category = "Rubiks")
+	int32 GetNumFreePieces(TSubclassOf<AVRubiksPiece> PieceClass) const;
+};
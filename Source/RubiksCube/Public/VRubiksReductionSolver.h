@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VRubiksCubeModel.h"
+#include <atomic>
+
+/**
+ * Solver for cubes of size 3 and up by reduction to a 3x3. The centers of each face are gathered, the edge pieces of
+ * each edge are paired up, then the cube is solved as a 3x3 by FVRubiksTwoPhaseSolver turning outer layers only.
+ * Centers and edges are moved by commutators, each one a pure 3-cycle of pieces of one kind (several at once when they
+ * line up), so nothing already solved is ever broken. Odd edge permutations, which no 3-cycle can fix, are detected
+ * before pairing and fixed with a single inner slice turn while it is still cheap, so there is no parity algorithm.
+ * Works on stickers (FVRubiksFaceletModel), every move costs O(Size); safe to call from any thread.
+ */
+class RUBIKSCUBE_API FVRubiksReductionSolver
+{
+public:
+	struct FSettings
+	{
+		//Budget of the 3x3 search, which keeps the best solution found by then. The stages before it always run to the end,
+		//only bCancel stops them
+		float TimeBudgetSeconds = 1.0f;
+
+		//Checked between commutators, a cancelled solve returns false
+		const std::atomic<bool>* bCancel = nullptr;
+
+		//Called on the solving thread with the moves of each stage as soon as that stage is done
+		TFunction<void(const TArray<FVRubiksMove>& StageMoves)> OnStageSolved;
+	};
+
+	//Solution as moves on the model. False for a 2x2, a broken model, a cancelled solve or a 3x3 stage that found nothing
+	//in its budget, the stages already reported stand
+	static bool SolveModel(const FVRubiksCubeModel& Model, const FSettings& Settings, TArray<FVRubiksMove>& OutMoves);
+};
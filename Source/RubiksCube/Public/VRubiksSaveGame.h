@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/SaveGame.h"
+#include "VRubiksCubeModel.h"
+#include "VRubiksSaveGame.generated.h"
+
+/**
+ * Save format of a whole cube. Everything is packed in one compact binary blob (about 3 bytes per piece plus 2 per history move),
+ * so a 16x16 cube saves in a few kilobytes.
+ */
+UCLASS()
+class RUBIKSCUBE_API UVRubiksSaveGame : public USaveGame
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<uint8> Data;
+
+public:
+	void Store(const FVRubiksCubeModel& Model, int32 Steps, float ElapsedTime, const TArray<FVRubiksMove>& History);
+
+	bool Restore(FVRubiksCubeModel& OutModel, int32& OutSteps, float& OutElapsedTime, TArray<FVRubiksMove>& OutHistory) const;
+};
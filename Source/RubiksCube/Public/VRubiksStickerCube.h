@@ -0,0 +1,138 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "VRubiksCube.h"
+#include "VRubiksFaceletModel.h"
+#include "VRubiksStickerCube.generated.h"
+
+class UProceduralMeshComponent;
+class UTexture2D;
+class UMaterialInstanceDynamic;
+
+/**
+ * Renders a cube of any size (up to 1024) as six textured faces instead of pieces.
+ * Each face samples a Size x Size sticker texture, and a move only uploads the rows or columns it changed.
+ * While a slice turns, its band of stickers is drawn by a small separate mesh and hidden on the faces.
+ *
+ * FaceMaterial parameters: texture "Stickers" (sampled with nearest filtering), scalar "FaceRotation" (rotate the UVs by
+ * -FaceRotation quarter turns around the center before sampling) and vector "HiddenRect" (min texture UV in RG, max in BA,
+ * compared after the rotation and drawn as the cube's inner color). BandMaterial only needs to show the vertex colors.
+ */
+UCLASS()
+class RUBIKSCUBE_API AVRubiksStickerCube : public AActor
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Rubiks", meta = (AllowPrivateAccess = "true"))
+	class USceneComponent * DummySceneComponent;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Rubiks", meta = (AllowPrivateAccess = "true"))
+	class USceneComponent * RotatorSceneComponent;
+
+	//One quad per face, in the layout face order
+	UPROPERTY()
+	TArray <UProceduralMeshComponent*> FaceComponents;
+
+	//Stickers of the slice being turned
+	UPROPERTY()
+	UProceduralMeshComponent * BandComponent;
+
+	UPROPERTY()
+	TArray <UTexture2D*> FaceTextures;
+
+	UPROPERTY()
+	TArray <UMaterialInstanceDynamic*> FaceMaterialInstances;
+
+	UPROPERTY(EditAnywhere, BlueprintGetter=GetSize, BlueprintSetter=SetSize, Category = "Rubiks", meta = (AllowPrivateAccess = "true"))
+	int32 Size;
+
+	FVRubiksFaceletModel Model;
+
+	//Face colors resolved once per build
+	TArray <FColor> Palette;
+
+	bool bIsAnimating;
+
+	int32 Steps;
+
+	//Turn animation in flight, destroyed if the cube is rebuilt or removed meanwhile
+	class FCTweenInstance* ActiveTween;
+
+	void CreateFace(int32 Face);
+
+	//Corners of a face quad (or of one sticker of it) in cube space, in UV order (0,0) (1,0) (1,1) (0,1)
+	void GetFaceCorners(int32 Face, float ColStart, float ColEnd, float RowStart, float RowEnd, float Lift, FVector (&OutCorners)[4]) const;
+
+	//Appends a quad facing out of Face, winding picked from the face normal
+	void AddQuad(int32 Face, const FVector (&Corners)[4], const FColor& Color, TArray<FVector>& Vertices, TArray<int32>& Triangles, TArray<FVector>& Normals, TArray<FVector2D>& UVs, TArray<FColor>& Colors) const;
+
+	//Copies a storage rect of a face to its texture, only that rect is uploaded
+	void UploadFaceRect(int32 Face, const FIntRect& Rect);
+
+	void UpdateFaceRotation(int32 Face);
+
+	void SetHiddenRect(int32 Face, const FIntRect& Rect);
+
+	//Builds the band mesh of the move around the rotator
+	void BuildBand(const FVRubiksMove& Move);
+
+	void CommitMove(const FVRubiksMove& Move);
+
+	FVector GetCenter() const;
+
+protected:
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	UPROPERTY(BlueprintAssignable, Category = "Rubiks")
+	FOnCubeChangedSignature OnCubeChanged;
+
+	UPROPERTY(BlueprintAssignable, Category = "Rubiks")
+	FOnCubeSolvedSignature OnCubeSolved;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks", meta = (ClampMin = "0.01"))
+	float StickerWidth;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks")
+	UMaterialInterface* FaceMaterial;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks")
+	UMaterialInterface* BandMaterial;
+
+	//Sticker color of each face, in the layout face order
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rubiks")
+	TArray<FLinearColor> FaceColors;
+
+	AVRubiksStickerCube();
+
+	UFUNCTION(BlueprintSetter, Category = "Rubiks")
+	void SetSize(int32 NewSize);
+
+	UFUNCTION(BlueprintGetter, Category = "Rubiks")
+	int32 GetSize();
+
+	UFUNCTION(BlueprintCallable, Category = "Rubiks")
+	void Build();
+
+	//Turns layer Layer of Axis (0 = X, 1 = Y, 2 = Z), animated over Speed seconds or applied at once when Speed is 0
+	UFUNCTION(BlueprintCallable, Category = "Rubiks")
+	void RotateLayer(int32 Axis, int32 Layer, int32 QuarterTurns, float Speed = 0.3f);
+
+	//Applies TotalSteps random moves at once and uploads the faces a single time
+	UFUNCTION(BlueprintCallable, Category = "Rubiks")
+	void Scramble(int32 TotalSteps);
+
+	UFUNCTION(BlueprintPure, Category = "Rubiks")
+	int32 GetSteps();
+
+	UFUNCTION(BlueprintPure, Category = "Rubiks")
+	bool IsCubeSolved();
+
+	UFUNCTION(BlueprintPure, Category = "Rubiks")
+	bool IsAnimating();
+};
@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Read-only lookup table kept in a file: a small header (magic, version, a fingerprint of whatever the table was derived
+ * from, payload size and CRC) followed by the raw payload. Map() memory maps the file, so pages are only read when the
+ * table touches them and processes mapping the same file share its physical pages. Size, version and fingerprint are
+ * always checked. The payload CRC, which reads every page, is checked the first time a file is mapped (or when it is
+ * written); a record of the file's path, time stamp, size and CRC is then kept in Saved/Rubiks so later runs skip it until
+ * the file changes. Rubiks.VerifyTableFiles checks it on every map.
+ * Files are looked up in Content/Rubiks first (a copy staged with the game as a non-asset file), then in Saved/Rubiks
+ * where tables generated at runtime are written.
+ */
+class RUBIKSCUBE_API FVRubiksTableFile
+{
+public:
+	FVRubiksTableFile();
+
+	~FVRubiksTableFile();
+
+	//Maps the first file named FileName whose header matches, false when none is found or the platform cannot map files
+	bool Map(const FString& FileName, uint32 Magic, uint16 Version, uint32 Fingerprint, int64 PayloadSize);
+
+	//Start of the mapped payload, aligned to 64 bytes, null until Map succeeds
+	const uint8* GetPayload() const { return Payload; }
+
+	//Writes the file to Saved/Rubiks next to the old one and swaps it in, so a crash never leaves a truncated table behind
+	static bool Write(const FString& FileName, uint32 Magic, uint16 Version, uint32 Fingerprint, const uint8* Data, int64 DataSize);
+
+private:
+	TUniquePtr<IMappedFileHandle> Handle;
+
+	TUniquePtr<IMappedFileRegion> Region;
+
+	const uint8* Payload;
+
+	bool MapPath(const FString& Path, uint32 Magic, uint16 Version, uint32 Fingerprint, int64 PayloadSize);
+};
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VRubiksCubeModel.h"
+#include <atomic>
+
+/**
+ * A 3x3 reduced to its corner and edge pieces (cubies): which cubie sits in each slot, and how it is twisted or flipped there.
+ * Slots and cubies use the solver's own numbering with Z as the up/down axis: corners 0-7, edges 0-7 in the Z = 0 and
+ * Z = 2 layers and edges 8-11 in the middle Z layer (the slice). Centers are left out, they never leave their face.
+ */
+struct RUBIKSCUBE_API FVRubiksCubieCube
+{
+	uint8 CornerPerm[8];
+
+	//0-2, which of the slot's faces the cubie's Z sticker is on
+	uint8 CornerOri[8];
+
+	uint8 EdgePerm[12];
+
+	//0-1, flipped by quarter turns around X only
+	uint8 EdgeOri[12];
+
+	//Solved cube
+	FVRubiksCubieCube();
+
+	//Applies Move, a cube state as well, after this state
+	void Multiply(const FVRubiksCubieCube& Move);
+
+	//Orientations add up and corners and edges are swapped the same number of times, true for every reachable state
+	bool IsSolvable() const;
+
+	//Phase 1 coordinates: corner twists (0-2186), edge flips (0-2047) and where the slice edges are (0-494)
+	int32 GetTwist() const;
+	void SetTwist(int32 Twist);
+	int32 GetFlip() const;
+	void SetFlip(int32 Flip);
+	int32 GetSlice() const;
+	void SetSlice(int32 Slice);
+
+	//Phase 2 coordinates: corner order (0-40319), order of the other edges (0-40319) and of the slice edges (0-23).
+	//The edge ones only mean something once the slice edges are back in the slice
+	int32 GetCornerPermutation() const;
+	void SetCornerPermutation(int32 Permutation);
+	int32 GetEdgePermutation() const;
+	void SetEdgePermutation(int32 Permutation);
+	int32 GetSlicePermutation() const;
+	void SetSlicePermutation(int32 Permutation);
+
+	//Reads a 3x3 model. The centers give the frame, the orientation turning the solver's frame into the model's, so a cube
+	//turned as a whole (middle layer moves included) is read the same. False for other sizes or a broken model
+	static bool FromModel(const FVRubiksCubeModel& Model, FVRubiksCubieCube& OutCube, uint8& OutFrame);
+
+	//Reads a 3x3 from its stickers. GetColor returns the home face (in FVRubiksFaceletModel order) of the sticker on the
+	//Normal side of a 3x3 cell, so bigger cubes reduced to a 3x3 can be read through their corners, edges and centers
+	static bool FromStickers(TFunctionRef<uint8(const FIntVector& Cell, const FIntVector& Normal)> GetColor, FVRubiksCubieCube& OutCube, uint8& OutFrame);
+};
+
+/**
+ * Two phase solver for the 3x3 (Kociemba's algorithm). Phase 1 searches for moves bringing the cube into the group
+ * generated by U, D, R2, L2, F2 and B2 turns, phase 2 solves it from there with those moves only. Both phases run IDA*
+ * on small coordinates through move tables, bounded by pruning tables built once by breadth first search. The search
+ * keeps looking for shorter solutions until one is at most TargetLength moves, the time budget runs out or it is cancelled.
+ * Moves are outer layer turns of a 3x3 in the model's own axes, safe to call from any thread.
+ */
+class RUBIKSCUBE_API FVRubiksTwoPhaseSolver
+{
+public:
+	struct FSettings
+	{
+		//Stops at the first solution this short, 21 is reached in milliseconds for almost every position
+		int32 TargetLength = 21;
+
+		float TimeBudgetSeconds = 1.0f;
+
+		//Checked between nodes, the best solution found so far is kept
+		const std::atomic<bool>* bCancel = nullptr;
+	};
+
+	//Solution in the solver's frame, false when none was found in time (or the cube cannot be solved)
+	static bool Solve(const FVRubiksCubieCube& Cube, const FSettings& Settings, TArray<FVRubiksMove>& OutMoves);
+
+	//Solution as moves on the model, which must be a 3x3
+	static bool SolveModel(const FVRubiksCubeModel& Model, const FSettings& Settings, TArray<FVRubiksMove>& OutMoves);
+
+	//Builds the move and pruning tables now instead of on the first solve
+	static void BuildTables();
+};
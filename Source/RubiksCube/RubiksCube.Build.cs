@@ -10,7 +10,7 @@ public class RubiksCube : ModuleRules
 	
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "UMG", "EnhancedInput" });
 
-		PrivateDependencyModuleNames.AddRange(new string[] { "FCTween" });
+		PrivateDependencyModuleNames.AddRange(new string[] { "FCTween", "ProceduralMeshComponent" });
 
 		// Uncomment if you are using Slate UI
 		// PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
@@ -3,4 +3,6 @@
 #include "RubiksCube.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_LOG_CATEGORY(LogRubiks);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, RubiksCube, "RubiksCube" );
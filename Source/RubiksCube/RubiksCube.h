@@ -4,3 +4,7 @@
 
 #include "CoreMinimal.h"
 
+DECLARE_LOG_CATEGORY_EXTERN(LogRubiks, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("Rubiks"), STATGROUP_Rubiks, STATCAT_Advanced);
+